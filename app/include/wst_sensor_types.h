@@ -25,6 +25,44 @@
 #define WST_CHANNEL_TYPE_LIGHT				(17)	// SENSOR_CHAN_LIGHT
 #define WST_CHANNEL_TYPE_GAS_RES			(30)	// SENSOR_CHAN_GAS_RES
 
+//
+// WST derived channel types, computed from channels of the same sensor,
+// in the range of sensor private channel types
+//
+#define WST_CHANNEL_TYPE_DEW_POINT			(0x4000)	// °C, from AMBIENT_TEMP and HUMIDITY
+#define WST_CHANNEL_TYPE_SEA_LEVEL_PRESS	(0x4001)	// kPa, from PRESS and AMBIENT_TEMP
+#define WST_CHANNEL_TYPE_ABS_HUMIDITY		(0x4002)	// g/m3, from AMBIENT_TEMP and HUMIDITY
+#define WST_CHANNEL_TYPE_HEAT_INDEX			(0x4003)	// °C, from AMBIENT_TEMP and HUMIDITY
+
+//
+// WST trigger types must match sensor trigger enum values defined in sensor.h
+//
+#define WST_TRIGGER_TYPE_DATA_READY			(1)		// SENSOR_TRIG_DATA_READY
+#define WST_TRIGGER_TYPE_DELTA				(2)		// SENSOR_TRIG_DELTA
+#define WST_TRIGGER_TYPE_THRESHOLD			(4)		// SENSOR_TRIG_THRESHOLD
+#define WST_TRIGGER_TYPE_TAP				(5)		// SENSOR_TRIG_TAP
+#define WST_TRIGGER_TYPE_MOTION				(8)		// SENSOR_TRIG_MOTION
+
+//
+// WST attribute types must match sensor attribute enum values defined in sensor.h
+//
+#define WST_ATTR_SAMPLING_FREQUENCY			(0)		// SENSOR_ATTR_SAMPLING_FREQUENCY
+#define WST_ATTR_LOWER_THRESH				(1)		// SENSOR_ATTR_LOWER_THRESH
+#define WST_ATTR_UPPER_THRESH				(2)		// SENSOR_ATTR_UPPER_THRESH
+#define WST_ATTR_SLOPE_TH					(3)		// SENSOR_ATTR_SLOPE_TH
+#define WST_ATTR_SLOPE_DUR					(4)		// SENSOR_ATTR_SLOPE_DUR
+#define WST_ATTR_HYSTERESIS					(5)		// SENSOR_ATTR_HYSTERESIS
+#define WST_ATTR_OVERSAMPLING				(6)		// SENSOR_ATTR_OVERSAMPLING
+#define WST_ATTR_FULL_SCALE					(7)		// SENSOR_ATTR_FULL_SCALE
+#define WST_ATTR_CONFIGURATION				(10)	// SENSOR_ATTR_CONFIGURATION
+
+//
+// WST burst filter stages, may be combined
+//
+#define WST_FILTER_MEDIAN					(1)		// median of the burst instead of mean
+#define WST_FILTER_HAMPEL					(2)		// outlier rejection within the burst
+#define WST_FILTER_EMA						(4)		// moving average across bursts
+
 
 //
 // Skip below by Devicetree generator
@@ -44,4 +82,29 @@ _Static_assert(
 	(WST_CHANNEL_TYPE_GAS_RES		== SENSOR_CHAN_GAS_RES),
 	"WST channel type defines and Sensor channel enums are not matching!");
 
+_Static_assert(
+	(WST_CHANNEL_TYPE_DEW_POINT		>= SENSOR_CHAN_PRIV_START) &&
+	(WST_CHANNEL_TYPE_HEAT_INDEX	< SENSOR_CHAN_MAX),
+	"WST derived channel types must be sensor private channel types!");
+
+_Static_assert(
+	(WST_TRIGGER_TYPE_DATA_READY	== SENSOR_TRIG_DATA_READY) &&
+	(WST_TRIGGER_TYPE_DELTA			== SENSOR_TRIG_DELTA) &&
+	(WST_TRIGGER_TYPE_THRESHOLD		== SENSOR_TRIG_THRESHOLD) &&
+	(WST_TRIGGER_TYPE_TAP			== SENSOR_TRIG_TAP) &&
+	(WST_TRIGGER_TYPE_MOTION		== SENSOR_TRIG_MOTION),
+	"WST trigger type defines and Sensor trigger enums are not matching!");
+
+_Static_assert(
+	(WST_ATTR_SAMPLING_FREQUENCY	== SENSOR_ATTR_SAMPLING_FREQUENCY) &&
+	(WST_ATTR_LOWER_THRESH			== SENSOR_ATTR_LOWER_THRESH) &&
+	(WST_ATTR_UPPER_THRESH			== SENSOR_ATTR_UPPER_THRESH) &&
+	(WST_ATTR_SLOPE_TH				== SENSOR_ATTR_SLOPE_TH) &&
+	(WST_ATTR_SLOPE_DUR				== SENSOR_ATTR_SLOPE_DUR) &&
+	(WST_ATTR_HYSTERESIS			== SENSOR_ATTR_HYSTERESIS) &&
+	(WST_ATTR_OVERSAMPLING			== SENSOR_ATTR_OVERSAMPLING) &&
+	(WST_ATTR_FULL_SCALE			== SENSOR_ATTR_FULL_SCALE) &&
+	(WST_ATTR_CONFIGURATION			== SENSOR_ATTR_CONFIGURATION),
+	"WST attribute defines and Sensor attribute enums are not matching!");
+
 #endif
@@ -19,6 +19,9 @@
 #include "wst_led_driver.h"
 #include "wst_sensor_config.h"
 #include "wst_sensor_utils.h"
+#include "wst_sensor_aggregate.h"
+#include "wst_sensor_report.h"
+#include "wst_sensor_types.h"
 #include "wst_cayenne_lpp.h"
 
 #include <zephyr/kernel.h>
@@ -49,6 +52,32 @@ WST_APP_BSS const struct device *key_device;
 WST_APP_BSS const struct device *led_device;
 #endif
 
+#if defined(CONFIG_WST_UPLINK_STATISTIC_MIN)
+#define WST_UPLINK_STATISTIC	wst_sensor_statistic_min
+#elif defined(CONFIG_WST_UPLINK_STATISTIC_MAX)
+#define WST_UPLINK_STATISTIC	wst_sensor_statistic_max
+#elif defined(CONFIG_WST_UPLINK_STATISTIC_LAST)
+#define WST_UPLINK_STATISTIC	wst_sensor_statistic_last
+#else
+#define WST_UPLINK_STATISTIC	wst_sensor_statistic_mean
+#endif
+
+//
+// Sensor values aggregated since the last uplink
+//
+WST_APP_BSS static wst_sensor_window_t sensor_window;
+
+//
+// Report-on-change state of the channels
+//
+WST_APP_BSS static wst_sensor_report_t sensor_report;
+
+//
+// Arguments of a value in thousandths printed with "%s%d.%03d"
+//
+#define WST_MILLI_ARG(v) \
+	((v) < 0) ? "-" : "", (int) (ABS(v) / 1000), (int) (ABS(v) % 1000)
+
 #if defined (CONFIG_WST_UI)
 static void key_event_handler(
 	const struct device *dev,
@@ -90,95 +119,97 @@ static void key_event_handler(
 }
 #endif
 
-static void stream_sensor_data(const wst_event_msg_t* msg, cayenne_lpp_stream_t* stream)
+//
+// Payload channel of a sensor channel, channels sharing a payload type
+// are kept apart by channel range
+//
+static uint8_t get_payload_channel(const struct sensor_chan_spec* spec)
 {
-	for (uint16_t i = 0; i < msg->sensor.count; i++) {
+	switch (spec->chan_type) {
+		case SENSOR_CHAN_DIE_TEMP:
+			return spec->chan_idx + 0x80;
+		case WST_CHANNEL_TYPE_DEW_POINT:
+			return spec->chan_idx + 0x40;
+		case WST_CHANNEL_TYPE_HEAT_INDEX:
+			return spec->chan_idx + 0x50;
+		case WST_CHANNEL_TYPE_SEA_LEVEL_PRESS:
+			return spec->chan_idx + 0x60;
+		default:
+			return spec->chan_idx;
+	}
+}
+
+static void stream_sensor_data(const wst_sensor_window_t* window, cayenne_lpp_stream_t* stream)
+{
+	int64_t now_ms = k_uptime_get();
+
+	LOG_INF("Sensor data captured at %s %u.%03u - %u.%03u s",
+		window->network_time ? "GPS time" : "uptime",
+		(uint32_t) (window->start_ms / MSEC_PER_SEC),
+		(uint32_t) (window->start_ms % MSEC_PER_SEC),
+		(uint32_t) (window->end_ms / MSEC_PER_SEC),
+		(uint32_t) (window->end_ms % MSEC_PER_SEC)
+	);
+
+	for (uint16_t i = 0; i < WST_SENSOR_CHANNEL_COUNT; i++) {
 
-		struct sensor_value val;
-		cayenne_lpp_value_t lpp_value;
 		cayenne_lpp_result_t result = cayenne_lpp_result_success;
-		const wst_sensor_value_t* value = &msg->sensor.values[i];
+		const wst_sensor_stats_t* stats = &window->stats[i];
 
-		if (wst_sensor_format_scalar == wst_sensor_get_channel_format(value->spec.chan_type)) {
+		if (!stats->count) {
+			continue;
+		}
 
-			wst_q31_to_sensor_value(
-				value->data.q31_data.readings[0].value,
-				value->data.q31_data.shift,
-				&val
-			);
+		int64_t mean = wst_sensor_stats_get(stats, wst_sensor_statistic_mean);
+		int64_t stddev = wst_sensor_stats_get_stddev(stats);
 
-			LOG_INF("%-20s : %6d.%06d",
-				wst_sensor_get_channel_name(value->spec.chan_type),
-				((val.val1 < 0) || (val.val2 < 0)) ? 0 - abs(val.val1) : abs(val.val1),
-				abs(val.val2)
-			);
-		};
-
-		switch (value->spec.chan_type) {
-			case SENSOR_CHAN_AMBIENT_TEMP:
-			case SENSOR_CHAN_DIE_TEMP:
-				{
-				lpp_value.temperature_sensor.celsius = sensor_value_to_float(&val);
-
-				result = cayenne_lpp_stream_write(
-					stream,
-					SENSOR_CHAN_DIE_TEMP == value->spec.chan_type ?
-						(value->spec.chan_idx + 0x80) :
-						value->spec.chan_idx,
-					cayenne_lpp_type_temperature_sensor,
-					&lpp_value);
-				}
-				break;
-
-			case SENSOR_CHAN_LIGHT:
-				{
-				lpp_value.illuminance_sensor.lux = sensor_value_to_float(&val);
-
-				result = cayenne_lpp_stream_write(
-					stream,
-					value->spec.chan_idx,
-					cayenne_lpp_type_illuminance_sensor,
-					&lpp_value);
-				}
-				break;
-
-			case SENSOR_CHAN_HUMIDITY:
-				{
-				lpp_value.humidity_sensor.rh = sensor_value_to_float(&val);
-
-				result = cayenne_lpp_stream_write(
-					stream,
-					value->spec.chan_idx,
-					cayenne_lpp_type_humidity_sensor,
-					&lpp_value);
-				}
-				break;
-
-			case SENSOR_CHAN_PRESS:
-				{
-				lpp_value.barometer.hpa = sensor_value_to_float(&val);
-
-				result = cayenne_lpp_stream_write(
-					stream,
-					value->spec.chan_idx,
-					cayenne_lpp_type_barometer,
-					&lpp_value);
-				}
-				break;
-
-			default:
-				break;
-		};
+		LOG_INF("%-20s %u : mean %s%d.%03d min %s%d.%03d max %s%d.%03d",
+			wst_sensor_get_channel_name(stats->spec.chan_type),
+			stats->spec.chan_idx,
+			WST_MILLI_ARG(mean),
+			WST_MILLI_ARG(stats->min),
+			WST_MILLI_ARG(stats->max)
+		);
+		LOG_INF("%-20s %u : sd %s%d.%03d n %u",
+			wst_sensor_get_channel_name(stats->spec.chan_type),
+			stats->spec.chan_idx,
+			WST_MILLI_ARG(stddev),
+			stats->count
+		);
+
+		int64_t value = wst_sensor_stats_get(stats, WST_UPLINK_STATISTIC);
+
+		if (WST_SENSOR_PAYLOAD_NONE == stats->payload_type) {
+			// channel is not encoded
+			continue;
+		}
+
+		if (!wst_sensor_report_is_due(&sensor_report, i, value, now_ms)) {
+			// channel didn't move past its deadband
+			continue;
+		}
+
+		// Integer only encoding, there is no FPU to convert through float
+		result = cayenne_lpp_stream_write_milli(
+			stream,
+			get_payload_channel(&stats->spec),
+			stats->payload_type,
+			value);
 
 		if (cayenne_lpp_result_error_end_of_stream == result) {
 			// return and send what we have serialized
 			return;
 		}
+
+		if (cayenne_lpp_result_success == result) {
+			wst_sensor_report_sent(&sensor_report, i, value);
+		}
 	}
 }
 
-static void process_sensor_data_event(wst_event_msg_t* msg, size_t max_size)
+static bool process_sensor_data_event(const wst_sensor_window_t* window, size_t max_size)
 {
+	bool sent = false;
 	size_t stream_size = 0;
 	const uint8_t* stream_buffer = NULL;
 
@@ -187,7 +218,7 @@ static void process_sensor_data_event(wst_event_msg_t* msg, size_t max_size)
 		NULL
 	);
 
-	stream_sensor_data(msg, stream);
+	stream_sensor_data(window, stream);
 
 	stream_buffer = cayenne_lpp_stream_get_buffer(
 		stream,
@@ -195,7 +226,7 @@ static void process_sensor_data_event(wst_event_msg_t* msg, size_t max_size)
 		&stream_size
 	);
 
-	if (stream_buffer)
+	if (stream_buffer && stream_size)
 	{
 		wst_event_msg_t* io_msg = sys_heap_alloc(
 			&events_pool,
@@ -217,8 +248,13 @@ static void process_sensor_data_event(wst_event_msg_t* msg, size_t max_size)
 		);
 
 		k_queue_alloc_append(&io_events_queue, io_msg);
+		sent = true;
+	} else {
+		LOG_INF("No channel moved past its deadband, uplink skipped");
 	}
 	cayenne_lpp_stream_delete(stream);
+
+	return sent;
 }
 
 static void application_thread(void *p1, void *p2, void *p3)
@@ -235,6 +271,9 @@ static void application_thread(void *p1, void *p2, void *p3)
 	bool busy = false;
 
 	size_t max_size = 10;
+	int64_t uplink_ms = k_uptime_get();
+
+	wst_sensor_window_reset(&sensor_window);
 
 	// Send join message to IO Thread
 	msg = sys_heap_alloc(&events_pool, sizeof(wst_event_msg_t));
@@ -274,16 +313,30 @@ static void application_thread(void *p1, void *p2, void *p3)
 
 		case wst_event_sensor_data_available:
 			LOG_INF("Data available message received");
-			if (joined && max_size && !busy)
+
+			// Values are aggregated until the next uplink, so that
+			// none is lost while the network is busy
+			wst_sensor_window_update(&sensor_window, msg);
+
+			if (joined && max_size && !busy && sensor_window.count &&
+				(k_uptime_get() - uplink_ms >= CONFIG_WST_UPLINK_INTERVAL_MS))
 			{
-				busy = true;
-				process_sensor_data_event(msg, max_size);
+				uplink_ms = k_uptime_get();
+				busy = process_sensor_data_event(&sensor_window, max_size);
+				wst_sensor_window_reset(&sensor_window);
 			}
 			break;
 
 		case wst_event_lorawan_send_completed:
 			LOG_INF("Send completed message received");
 			busy = false;
+
+			// Undelivered channels are sent again on the next uplink
+			wst_sensor_report_completed(
+				&sensor_report,
+				msg->lorawan.send_completed.result == 0,
+				k_uptime_get()
+			);
 			break;
 
 		default:
@@ -386,6 +439,16 @@ void wst_app_thread_entry(void *p1, void *p2, void *p3)
 	wst_key_driver_set_handler(key_device, key_event_handler, NULL);
 #endif
 
+	//
+	// Initialize report-on-change thresholds from devicetree, the
+	// application may change them at runtime.
+	//
+	wst_sensor_report_init(&sensor_report);
+
+	for (uint16_t i = 0; i < WST_SENSOR_CHANNEL_COUNT; i++) {
+		wst_sensor_report_set_deadband(&sensor_report, i, wst_sensor_get_deadband(i));
+	}
+
 	//
 	// Switch APP thread to user mode
 	//
@@ -144,15 +144,62 @@ void cayenne_lpp_stream_delete(cayenne_lpp_stream_t* stream)
 	free(stream);
 }
 
-cayenne_lpp_result_t cayenne_lpp_stream_write(
+//
+// Writes record of a value in the resolution units of the data type
+//
+static cayenne_lpp_result_t cayenne_lpp_write_record(
 	cayenne_lpp_stream_t* stream,
 	uint8_t channel,
 	cayenne_lpp_type_t type,
-	const cayenne_lpp_value_t* value)
+	int64_t val)
 {
-	__ASSERT_NO_MSG(stream);
-	__ASSERT_NO_MSG(value);
+	switch (type)
+	{
+		case cayenne_lpp_type_digital_input:
+		case cayenne_lpp_type_digital_output:
+		case cayenne_lpp_type_humidity_sensor:
+			// 1 byte, unsigned
+			if ((val < 0) || (val > UINT8_MAX))
+				return cayenne_lpp_result_error_out_of_range;
+			stream->buffer[stream->wr_pos++] = channel;
+			stream->buffer[stream->wr_pos++] = (uint8_t) type;
+			stream->buffer[stream->wr_pos++] = LO_BYTE(val);
+			break;
+
+		case cayenne_lpp_type_analog_input:
+		case cayenne_lpp_type_analog_output:
+		case cayenne_lpp_type_temperature_sensor:
+			// 2 bytes, signed
+			if ((val < INT16_MIN) || (val > INT16_MAX))
+				return cayenne_lpp_result_error_out_of_range;
+			stream->buffer[stream->wr_pos++] = channel;
+			stream->buffer[stream->wr_pos++] = (uint8_t) type;
+			stream->buffer[stream->wr_pos++] = HI_BYTE(val);
+			stream->buffer[stream->wr_pos++] = LO_BYTE(val);
+			break;
+
+		case cayenne_lpp_type_barometer:
+		case cayenne_lpp_type_illuminance_sensor:
+			// 2 bytes, unsigned
+			if ((val < 0) || (val > UINT16_MAX))
+				return cayenne_lpp_result_error_out_of_range;
+			stream->buffer[stream->wr_pos++] = channel;
+			stream->buffer[stream->wr_pos++] = (uint8_t) type;
+			stream->buffer[stream->wr_pos++] = HI_BYTE(val);
+			stream->buffer[stream->wr_pos++] = LO_BYTE(val);
+			break;
+
+		default:
+			return cayenne_lpp_result_error_unknown_type;
+	}
+
+	return cayenne_lpp_result_success;
+}
 
+static cayenne_lpp_result_t cayenne_lpp_write_check(
+	cayenne_lpp_stream_t* stream,
+	cayenne_lpp_type_t type)
+{
 	// check supported cayenne type
 	cayenne_lpp_result_t result = cayenne_lpp_type_check(type);
 	if (cayenne_lpp_result_success != result) {
@@ -165,88 +212,168 @@ cayenne_lpp_result_t cayenne_lpp_stream_write(
 		return cayenne_lpp_result_error_overflow;
 	}
 
+	return cayenne_lpp_result_success;
+}
+
+cayenne_lpp_result_t cayenne_lpp_stream_write(
+	cayenne_lpp_stream_t* stream,
+	uint8_t channel,
+	cayenne_lpp_type_t type,
+	const cayenne_lpp_value_t* value)
+{
+	__ASSERT_NO_MSG(stream);
+	__ASSERT_NO_MSG(value);
+
+	int32_t val;
+
+	cayenne_lpp_result_t result = cayenne_lpp_write_check(stream, type);
+	if (cayenne_lpp_result_success != result) {
+		return result;
+	}
+
 	switch (type)
 	{
 		case cayenne_lpp_type_digital_input:
 		case cayenne_lpp_type_digital_output:
-			{
 			// 1 byte, unsigned
-			stream->buffer[stream->wr_pos++] = channel;
-			stream->buffer[stream->wr_pos++] = (uint8_t) type;
-			stream->buffer[stream->wr_pos++] = value->digital_input;
-			}
+			val = value->digital_input;
 			break;
 
 		case cayenne_lpp_type_analog_input:
 		case cayenne_lpp_type_analog_output:
-			{
 			// 2 bytes, signed, 0.01
-			int32_t val = (int32_t) ROUND(value->analog_input * 100.0f);
-			if ((val < INT16_MIN) || (val > INT16_MAX))
-				return cayenne_lpp_result_error_out_of_range;
-			stream->buffer[stream->wr_pos++] = channel;
-			stream->buffer[stream->wr_pos++] = (uint8_t) type;
-			stream->buffer[stream->wr_pos++] = HI_BYTE(val);
-			stream->buffer[stream->wr_pos++] = LO_BYTE(val);
-			}
+			val = (int32_t) ROUND(value->analog_input * 100.0f);
 			break;
 
 		case cayenne_lpp_type_temperature_sensor:
-			{
 			// 2 bytes, signed, 0.1°C
-			int32_t val = (int32_t) ROUND(value->temperature_sensor.celsius * 10.0f);
-			if ((val < INT16_MIN) || (val > INT16_MAX))
-				return cayenne_lpp_result_error_out_of_range;
-			stream->buffer[stream->wr_pos++] = channel;
-			stream->buffer[stream->wr_pos++] = (uint8_t) type;
-			stream->buffer[stream->wr_pos++] = HI_BYTE(val);
-			stream->buffer[stream->wr_pos++] = LO_BYTE(val);
-			}
+			val = (int32_t) ROUND(value->temperature_sensor.celsius * 10.0f);
 			break;
 
 		case cayenne_lpp_type_humidity_sensor:
-			{
 			// 1 byte, unsigned, 0.5%
 			if ((value->humidity_sensor.rh < 0) || (value->humidity_sensor.rh > 100.0f))
 				return cayenne_lpp_result_error_out_of_range;
-			uint32_t val = (uint32_t) ROUND(value->humidity_sensor.rh * 2.0f);
-			stream->buffer[stream->wr_pos++] = channel;
-			stream->buffer[stream->wr_pos++] = (uint8_t) type;
-			stream->buffer[stream->wr_pos++] = LO_BYTE(val);
-			}
+			val = (int32_t) ROUND(value->humidity_sensor.rh * 2.0f);
 			break;
 
 		case cayenne_lpp_type_barometer:
-			{
 			// 2 bytes, unsigned, 0.1 hPa
-			int32_t val = (int32_t) ROUND(value->barometer.hpa * 10.0f);
-			if ((val < 0) || (val > UINT16_MAX))
-				return cayenne_lpp_result_error_out_of_range;
-			stream->buffer[stream->wr_pos++] = channel;
-			stream->buffer[stream->wr_pos++] = (uint8_t) type;
-			stream->buffer[stream->wr_pos++] = HI_BYTE(val);
-			stream->buffer[stream->wr_pos++] = LO_BYTE(val);
-			}
+			val = (int32_t) ROUND(value->barometer.hpa * 10.0f);
 			break;
 
 		case cayenne_lpp_type_illuminance_sensor:
-			{
 			// 2 bytes, unsigned, 1 lux
-			int32_t val = (int32_t) ROUND(value->illuminance_sensor.lux);
-			if ((val < 0) || (val > UINT16_MAX))
+			val = (int32_t) ROUND(value->illuminance_sensor.lux);
+			break;
+
+		default:
+			return cayenne_lpp_result_error_unknown_type;
+	}
+
+	return cayenne_lpp_write_record(stream, channel, type, val);
+}
+
+//
+// Divides rounding half away from zero, as ROUND() does, den > 0
+//
+static int64_t cayenne_lpp_round_div(int64_t num, int64_t den)
+{
+	return (num >= 0) ? ((num + den / 2) / den) : -((-num + den / 2) / den);
+}
+
+//
+// Writes value num / den, den > 0, with integer arithmetic only
+//
+static cayenne_lpp_result_t cayenne_lpp_write_fixed(
+	cayenne_lpp_stream_t* stream,
+	uint8_t channel,
+	cayenne_lpp_type_t type,
+	int64_t num,
+	int64_t den)
+{
+	int64_t resolution;
+
+	cayenne_lpp_result_t result = cayenne_lpp_write_check(stream, type);
+	if (cayenne_lpp_result_success != result) {
+		return result;
+	}
+
+	switch (type)
+	{
+		case cayenne_lpp_type_digital_input:
+		case cayenne_lpp_type_digital_output:
+		case cayenne_lpp_type_illuminance_sensor:
+			// 1
+			resolution = 1;
+			break;
+
+		case cayenne_lpp_type_analog_input:
+		case cayenne_lpp_type_analog_output:
+			// 0.01
+			resolution = 100;
+			break;
+
+		case cayenne_lpp_type_temperature_sensor:
+		case cayenne_lpp_type_barometer:
+			// 0.1
+			resolution = 10;
+			break;
+
+		case cayenne_lpp_type_humidity_sensor:
+			// 0.5%
+			if ((num < 0) || (num > 100 * den))
 				return cayenne_lpp_result_error_out_of_range;
-			stream->buffer[stream->wr_pos++] = channel;
-			stream->buffer[stream->wr_pos++] = (uint8_t) type;
-			stream->buffer[stream->wr_pos++] = HI_BYTE(val);
-			stream->buffer[stream->wr_pos++] = LO_BYTE(val);
-			}
+			resolution = 2;
 			break;
 
 		default:
 			return cayenne_lpp_result_error_unknown_type;
 	}
 
-	return cayenne_lpp_result_success;
+	// keep num * resolution in range, values this large don't fit any type
+	if ((num > INT64_MAX / 100) || (num < -(INT64_MAX / 100)))
+		return cayenne_lpp_result_error_out_of_range;
+
+	return cayenne_lpp_write_record(
+		stream,
+		channel,
+		type,
+		cayenne_lpp_round_div(num * resolution, den));
+}
+
+cayenne_lpp_result_t cayenne_lpp_stream_write_q31(
+	cayenne_lpp_stream_t* stream,
+	uint8_t channel,
+	cayenne_lpp_type_t type,
+	int32_t q,
+	int8_t shift)
+{
+	__ASSERT_NO_MSG(stream);
+
+	// value is q * 2^(shift - 31)
+	if (shift > 31) {
+		if (shift - 31 > 31)
+			return cayenne_lpp_result_error_out_of_range;
+		return cayenne_lpp_write_fixed(
+			stream, channel, type, (int64_t) q * (1LL << (shift - 31)), 1);
+	}
+
+	if (shift < -31)
+		return cayenne_lpp_result_error_out_of_range;
+
+	return cayenne_lpp_write_fixed(stream, channel, type, q, 1LL << (31 - shift));
+}
+
+cayenne_lpp_result_t cayenne_lpp_stream_write_milli(
+	cayenne_lpp_stream_t* stream,
+	uint8_t channel,
+	cayenne_lpp_type_t type,
+	int64_t milli)
+{
+	__ASSERT_NO_MSG(stream);
+
+	return cayenne_lpp_write_fixed(stream, channel, type, milli, 1000);
 }
 
 cayenne_lpp_result_t cayenne_lpp_stream_read(
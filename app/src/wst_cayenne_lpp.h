@@ -256,6 +256,52 @@ cayenne_lpp_result_t cayenne_lpp_stream_write(
 	const cayenne_lpp_value_t* value);
 
 
+/**
+ * @brief Writes fixed point q31 value to encoding stream.
+ *
+ * Value is q * 2^(shift - 31), as in Zephyr sensor q31 data. It is
+ * converted to the resolution of the data type with integer arithmetic
+ * only, rounding half away from zero as cayenne_lpp_stream_write() does.
+ *
+ * @param[in] stream      opaque pointer to the stream
+ * @param[in] channel     the data channel to write
+ * @param[in] type        the data type to write
+ * @param[in] q           q31 value
+ * @param[in] shift       q31 value shift
+ *
+ * @return @cayenne_lpp_result_success on success or one of the error codes
+ *         of cayenne_lpp_stream_write().
+ */
+cayenne_lpp_result_t cayenne_lpp_stream_write_q31(
+	cayenne_lpp_stream_t* stream,
+	uint8_t channel,
+	cayenne_lpp_type_t type,
+	int32_t q,
+	int8_t shift);
+
+
+/**
+ * @brief Writes value in thousandths to encoding stream.
+ *
+ * Value is converted to the resolution of the data type with integer
+ * arithmetic only, rounding half away from zero as cayenne_lpp_stream_write()
+ * does.
+ *
+ * @param[in] stream      opaque pointer to the stream
+ * @param[in] channel     the data channel to write
+ * @param[in] type        the data type to write
+ * @param[in] milli       value in thousandths
+ *
+ * @return @cayenne_lpp_result_success on success or one of the error codes
+ *         of cayenne_lpp_stream_write().
+ */
+cayenne_lpp_result_t cayenne_lpp_stream_write_milli(
+	cayenne_lpp_stream_t* stream,
+	uint8_t channel,
+	cayenne_lpp_type_t type,
+	int64_t milli);
+
+
 /**
  * @brief Reads value from decoding stream.
  *
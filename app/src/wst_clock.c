@@ -0,0 +1,68 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "wst_clock.h"
+
+#include <zephyr/kernel.h>
+
+#if defined(CONFIG_LORAWAN_APP_CLOCK_SYNC)
+#include <zephyr/lorawan/lorawan.h>
+#endif
+
+#include <errno.h>
+
+#if defined(CONFIG_LORAWAN_APP_CLOCK_SYNC)
+//
+// Offset of the last synchronization. Clock sync service keeps GPS time
+// as uptime seconds plus a whole seconds offset, corrected on each sync.
+//
+static struct k_spinlock offset_lock;
+static int64_t network_offset_ms;
+static bool network_offset_valid;
+#endif
+
+int wst_clock_get_network_offset(int64_t* offset_ms)
+{
+#if defined(CONFIG_LORAWAN_APP_CLOCK_SYNC)
+	uint32_t gps_time;
+	int64_t before_ms = k_uptime_get();
+
+	int rc = lorawan_clock_sync_get(&gps_time);
+	if (rc != 0) {
+		return rc;
+	}
+
+	int64_t after_ms = k_uptime_get();
+
+	k_spinlock_key_t key = k_spin_lock(&offset_lock);
+
+	// GPS time is taken at an uptime second between both reads, the
+	// offset is exact only if they fall within the same second. Reads
+	// across a second boundary keep the offset of the last sync.
+	if ((before_ms / MSEC_PER_SEC) == (after_ms / MSEC_PER_SEC)) {
+		network_offset_ms = ((int64_t) gps_time - after_ms / MSEC_PER_SEC) * MSEC_PER_SEC;
+		network_offset_valid = true;
+	}
+
+	*offset_ms = network_offset_ms;
+	rc = network_offset_valid ? 0 : -EAGAIN;
+
+	k_spin_unlock(&offset_lock, key);
+	return rc;
+#else
+	ARG_UNUSED(offset_ms);
+	return -ENOTSUP;
+#endif
+}
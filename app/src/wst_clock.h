@@ -0,0 +1,34 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Returns offset between system uptime and network time.
+ *
+ * Network time is GPS epoch time as provided by the LoRaWAN application
+ * layer clock synchronization service. Adding the offset to k_uptime_get()
+ * gives network time in milliseconds. The returned offset is the whole
+ * seconds offset the service keeps to uptime, and it only changes when
+ * the service synchronizes again.
+ *
+ * @param[out] offset_ms   network time minus uptime, in ms
+ *
+ * @return 0 on success, -EAGAIN if network time is not yet known,
+ *         -ENOTSUP if clock synchronization is not enabled.
+ */
+int wst_clock_get_network_offset(int64_t* offset_ms);
@@ -72,6 +72,9 @@ typedef union wst_sensor_data {
 
 typedef struct wst_sensor_value {
 	struct sensor_chan_spec spec;
+	uint16_t slot;				// index of the channel among all configured channels
+	uint8_t payload_type;		// target payload type, WST_SENSOR_PAYLOAD_NONE if not encoded
+	uint32_t time_delta_ms;		// capture time, relative to the message timestamp
 	wst_sensor_data_t data;
 } wst_sensor_value_t;
 
@@ -79,6 +82,8 @@ typedef struct wst_event_msg {
 	wst_event_t event;
 	union {
 		struct {
+			int64_t timestamp_ms;	// capture time of the earliest value
+			bool network_time;		// timestamp is GPS time if true, uptime otherwise
 			uint16_t count;
 			wst_sensor_value_t values[0];
 		} sensor;
@@ -0,0 +1,161 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "wst_sensor_aggregate.h"
+#include "wst_sensor_utils.h"
+
+#include <zephyr/sys/math_extras.h>
+#include <zephyr/sys/util.h>
+
+#include <string.h>
+
+void wst_sensor_window_reset(wst_sensor_window_t* window)
+{
+	memset(window, 0, sizeof(*window));
+}
+
+void wst_sensor_stats_update(wst_sensor_stats_t* stats, int64_t value)
+{
+	if (!stats->count) {
+		stats->min = value;
+		stats->max = value;
+	} else {
+		stats->min = MIN(stats->min, value);
+		stats->max = MAX(stats->max, value);
+	}
+
+	stats->last = value;
+
+	if (!stats->count) {
+		stats->offset = value;
+	}
+	stats->count++;
+
+	// Exact sums keep the mean free of the truncation bias of an
+	// incremental update. The window is not reset while the device is
+	// not joined and differences of wide channels such as gas resistance
+	// in thousandths of an ohm square past 64 bits, sum2 saturates then.
+	int64_t delta = value - stats->offset;
+	uint64_t magnitude = (delta < 0) ? -(uint64_t) delta : (uint64_t) delta;
+	uint64_t square;
+
+	stats->sum += delta;
+
+	if (u64_mul_overflow(magnitude, magnitude, &square) ||
+		u64_add_overflow(stats->sum2, square, &stats->sum2)) {
+		stats->sum2 = WST_SENSOR_STATS_SUM2_SATURATED;
+	}
+}
+
+static int64_t div_round(int64_t dividend, int64_t divisor)
+{
+	return (dividend < 0) ?
+		(dividend - divisor / 2) / divisor :
+		(dividend + divisor / 2) / divisor;
+}
+
+void wst_sensor_window_update(wst_sensor_window_t* window, const wst_event_msg_t* msg)
+{
+	for (uint16_t i = 0; i < msg->sensor.count; i++) {
+		const wst_sensor_value_t* value = &msg->sensor.values[i];
+
+		if ((value->slot >= WST_SENSOR_CHANNEL_COUNT) ||
+			(wst_sensor_format_scalar != wst_sensor_get_channel_format(value->spec.chan_type))) {
+			continue;
+		}
+
+		int64_t time_ms = msg->sensor.timestamp_ms + value->time_delta_ms;
+
+		if (!window->count) {
+			window->start_ms = time_ms;
+			window->end_ms = time_ms;
+			window->network_time = msg->sensor.network_time;
+		} else {
+			window->start_ms = MIN(window->start_ms, time_ms);
+			window->end_ms = MAX(window->end_ms, time_ms);
+		}
+		window->count++;
+
+		wst_sensor_stats_t* stats = &window->stats[value->slot];
+
+		stats->spec = value->spec;
+		stats->payload_type = value->payload_type;
+
+		wst_sensor_stats_update(
+			stats,
+			wst_q31_to_milli(value->data.q31_data.readings[0].value, value->data.q31_data.shift)
+		);
+	}
+}
+
+int64_t wst_sensor_stats_get(const wst_sensor_stats_t* stats, wst_sensor_statistic_t statistic)
+{
+	switch (statistic) {
+		case wst_sensor_statistic_min:
+			return stats->min;
+		case wst_sensor_statistic_max:
+			return stats->max;
+		case wst_sensor_statistic_last:
+			return stats->last;
+		case wst_sensor_statistic_mean:
+		default:
+			return stats->offset + div_round(stats->sum, (int64_t) stats->count);
+	}
+}
+
+static uint64_t isqrt64(uint64_t value)
+{
+	uint64_t root = 0;
+	uint64_t bit = BIT64(62);
+
+	while (bit > value) {
+		bit >>= 2;
+	}
+
+	while (bit) {
+		if (value >= root + bit) {
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return root;
+}
+
+int64_t wst_sensor_stats_get_stddev(const wst_sensor_stats_t* stats)
+{
+	if (stats->count < 2) {
+		return 0;
+	}
+
+	if (WST_SENSOR_STATS_SUM2_SATURATED == stats->sum2) {
+		// spread is beyond the range of the sums, report the largest
+		// standard deviation they can express
+		return (int64_t) isqrt64(UINT64_MAX / (stats->count - 1));
+	}
+
+	// Sum of squared differences from the mean is sum2 - sum^2 / count,
+	// with sum split into quotient and remainder so that sum^2 never
+	// overflows
+	int64_t count = (int64_t) stats->count;
+	int64_t quotient = stats->sum / count;
+	int64_t remainder = stats->sum % count;
+	uint64_t square = (uint64_t) (quotient * (stats->sum + remainder) + remainder * remainder / count);
+	uint64_t m2 = (stats->sum2 > square) ? stats->sum2 - square : 0;
+
+	return (int64_t) isqrt64(m2 / (stats->count - 1));
+}
@@ -0,0 +1,110 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include "wst_sensor_config.h"
+#include "wst_events.h"
+
+#include <zephyr/drivers/sensor.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum wst_sensor_statistic {
+	wst_sensor_statistic_mean,
+	wst_sensor_statistic_min,
+	wst_sensor_statistic_max,
+	wst_sensor_statistic_last,
+} wst_sensor_statistic_t;
+
+//
+// Running statistics of a scalar channel, values are in thousandths
+// of the channel unit
+//
+typedef struct wst_sensor_stats {
+	struct sensor_chan_spec spec;
+	uint8_t payload_type;
+	uint32_t count;
+	int64_t min;
+	int64_t max;
+	int64_t last;
+	int64_t offset;			// first value, sums are taken relative to it
+	int64_t sum;			// exact sum of differences from the offset
+	uint64_t sum2;			// sum of squared differences from the offset, saturating
+} wst_sensor_stats_t;
+
+//
+// Value of sum2 once the squared differences no longer fit in 64 bits
+//
+#define WST_SENSOR_STATS_SUM2_SATURATED		UINT64_MAX
+
+//
+// Aggregation window, statistics of each channel slot since the window
+// was reset
+//
+typedef struct wst_sensor_window {
+	int64_t start_ms;		// capture time of the first value
+	int64_t end_ms;			// capture time of the last value
+	bool network_time;		// times are GPS time if true, uptime otherwise
+	uint32_t count;			// number of aggregated values
+	wst_sensor_stats_t stats[WST_SENSOR_CHANNEL_COUNT];
+} wst_sensor_window_t;
+
+/**
+ * @brief Resets aggregation window.
+ *
+ * @param[out] window      window to reset
+ */
+void wst_sensor_window_reset(wst_sensor_window_t* window);
+
+/**
+ * @brief Adds scalar values of a sensor message to aggregation window.
+ *
+ * Values of other formats are ignored.
+ *
+ * @param[in,out] window   aggregation window
+ * @param[in]  msg         sensor message
+ */
+void wst_sensor_window_update(wst_sensor_window_t* window, const wst_event_msg_t* msg);
+
+/**
+ * @brief Adds a value to channel statistics.
+ *
+ * @param[in,out] stats    channel statistics
+ * @param[in]  value       value in thousandths of the channel unit
+ */
+void wst_sensor_stats_update(wst_sensor_stats_t* stats, int64_t value);
+
+/**
+ * @brief Returns statistic of a channel.
+ *
+ * @param[in]  stats       channel statistics, with at least one value
+ * @param[in]  statistic   statistic to return
+ *
+ * @return Statistic in thousandths of the channel unit.
+ */
+int64_t wst_sensor_stats_get(const wst_sensor_stats_t* stats, wst_sensor_statistic_t statistic);
+
+/**
+ * @brief Returns sample standard deviation of a channel.
+ *
+ * @param[in]  stats       channel statistics
+ *
+ * @return Standard deviation in thousandths of the channel unit,
+ *         0 for less than two values, the largest deviation the sums
+ *         can express once sum2 saturated.
+ */
+int64_t wst_sensor_stats_get_stddev(const wst_sensor_stats_t* stats);
@@ -0,0 +1,239 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "wst_sensor_client.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+
+#include <errno.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(wst_sensor_client);
+
+//
+// Registered clients, the registry is shared by the SENSOR thread,
+// the stream thread and client threads changing their intervals
+//
+static wst_sensor_client_t* clients[CONFIG_WST_SENSOR_CLIENT_MAX];
+static uint16_t client_count;
+static struct k_spinlock clients_lock;
+
+static atomic_t intervals_changed;
+static struct k_sem* intervals_wakeup;
+
+void wst_sensor_client_init(struct k_sem* wakeup)
+{
+	intervals_wakeup = wakeup;
+}
+
+int wst_sensor_client_open(wst_sensor_client_t* client, const char* name, struct k_queue* queue)
+{
+	int rc = 0;
+
+	client->name = name;
+	client->queue = queue;
+	memset(client->interval_ms, 0, sizeof(client->interval_ms));
+	memset(client->next_ms, 0, sizeof(client->next_ms));
+
+	k_spinlock_key_t key = k_spin_lock(&clients_lock);
+
+	if (client_count < ARRAY_SIZE(clients)) {
+		clients[client_count++] = client;
+	} else {
+		rc = -ENOMEM;
+	}
+
+	k_spin_unlock(&clients_lock, key);
+
+	if (rc == 0) {
+		LOG_INF("%s client opened", name);
+	} else {
+		LOG_ERR("%s client not opened, %u clients max", name, CONFIG_WST_SENSOR_CLIENT_MAX);
+	}
+	return rc;
+}
+
+int wst_sensor_client_set_interval(wst_sensor_client_t* client, uint16_t sensor, uint32_t interval_ms)
+{
+	if (sensor >= WST_SENSOR_COUNT) {
+		return -EINVAL;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&clients_lock);
+
+	client->interval_ms[sensor] = interval_ms;
+	// First value is delivered as soon as it's available
+	client->next_ms[sensor] = 0;
+
+	k_spin_unlock(&clients_lock, key);
+
+	LOG_INF("%s client sensor %u interval %u ms", client->name, sensor, interval_ms);
+
+	atomic_set(&intervals_changed, 1);
+	if (intervals_wakeup) {
+		k_sem_give(intervals_wakeup);
+	}
+	return 0;
+}
+
+uint32_t wst_sensor_client_get_interval(uint16_t sensor)
+{
+	uint32_t interval_ms = UINT32_MAX;
+
+	if (sensor >= WST_SENSOR_COUNT) {
+		return 0;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&clients_lock);
+
+	// Sensor is sampled at the shortest interval requested by any client
+	for (uint16_t i = 0; i < client_count; i++) {
+		if (clients[i]->interval_ms[sensor]) {
+			interval_ms = MIN(interval_ms, clients[i]->interval_ms[sensor]);
+		}
+	}
+
+	k_spin_unlock(&clients_lock, key);
+
+	return (interval_ms == UINT32_MAX) ? 0 : interval_ms;
+}
+
+bool wst_sensor_client_intervals_changed(void)
+{
+	return atomic_clear(&intervals_changed) != 0;
+}
+
+//
+// Returns bit mask of the sensors due for the client, and moves their
+// next delivery time. Must be called with the clients lock held.
+//
+static uint32_t get_client_due_sensors(wst_sensor_client_t* client, uint32_t sensors, uint32_t triggered, int64_t now)
+{
+	uint32_t due = 0;
+
+	for (uint16_t i = 0; i < WST_SENSOR_COUNT; i++) {
+		uint32_t interval_ms = client->interval_ms[i];
+
+		if (!(sensors & BIT(i)) || !interval_ms) {
+			continue;
+		}
+
+		if (triggered & BIT(i)) {
+			due |= BIT(i);
+			continue;
+		}
+
+		// Hardware period is shorter or equal, and samples jitter around it,
+		// so accept samples up to half of the client interval early.
+		if (now >= client->next_ms[i] - interval_ms / 2) {
+			due |= BIT(i);
+
+			client->next_ms[i] = MAX(client->next_ms[i], now - interval_ms / 2) + interval_ms;
+		}
+	}
+	return due;
+}
+
+static wst_event_msg_t* copy_sensor_values(const wst_event_msg_t* msg, uint32_t sensors, uint16_t count)
+{
+	wst_event_msg_t* copy = sys_heap_alloc(
+		&events_pool,
+		sizeof(wst_event_msg_t) + sizeof(wst_sensor_value_t) * count
+	);
+
+	if (!copy) {
+		return NULL;
+	}
+
+	copy->event = msg->event;
+	copy->sensor.timestamp_ms = msg->sensor.timestamp_ms;
+	copy->sensor.network_time = msg->sensor.network_time;
+	copy->sensor.count = 0;
+
+	for (uint16_t i = 0; i < msg->sensor.count; i++) {
+		if (sensors & BIT(wst_sensor_get_slot_sensor(msg->sensor.values[i].slot))) {
+			copy->sensor.values[copy->sensor.count++] = msg->sensor.values[i];
+		}
+	}
+	return copy;
+}
+
+static uint16_t count_sensor_values(const wst_event_msg_t* msg, uint32_t sensors)
+{
+	uint16_t count = 0;
+
+	for (uint16_t i = 0; i < msg->sensor.count; i++) {
+		if (sensors & BIT(wst_sensor_get_slot_sensor(msg->sensor.values[i].slot))) {
+			count++;
+		}
+	}
+	return count;
+}
+
+void wst_sensor_client_publish(wst_event_msg_t* msg, uint32_t triggered)
+{
+	wst_sensor_client_t* targets[CONFIG_WST_SENSOR_CLIENT_MAX];
+	uint32_t due[CONFIG_WST_SENSOR_CLIENT_MAX];
+	uint16_t target_count = 0;
+	uint32_t sensors = 0;
+	int64_t now = k_uptime_get();
+
+	for (uint16_t i = 0; i < msg->sensor.count; i++) {
+		sensors |= BIT(wst_sensor_get_slot_sensor(msg->sensor.values[i].slot));
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&clients_lock);
+
+	for (uint16_t i = 0; i < client_count; i++) {
+		uint32_t client_due = get_client_due_sensors(clients[i], sensors, triggered, now);
+
+		if (client_due) {
+			targets[target_count] = clients[i];
+			due[target_count] = client_due;
+			target_count++;
+		}
+	}
+
+	k_spin_unlock(&clients_lock, key);
+
+	// The message itself is handed over to a client taking all values,
+	// once the copies for the other clients are made
+	wst_sensor_client_t* owner = NULL;
+
+	for (uint16_t i = 0; i < target_count; i++) {
+		uint16_t count = count_sensor_values(msg, due[i]);
+
+		if (!owner && (count == msg->sensor.count)) {
+			owner = targets[i];
+			continue;
+		}
+
+		wst_event_msg_t* copy = copy_sensor_values(msg, due[i], count);
+		if (copy) {
+			k_queue_alloc_append(targets[i]->queue, copy);
+		} else {
+			LOG_WRN("%s client dropped %u values, no memory in shared pool", targets[i]->name, count);
+		}
+	}
+
+	if (owner) {
+		k_queue_alloc_append(owner->queue, msg);
+	} else {
+		sys_heap_free(&events_pool, msg);
+	}
+}
@@ -0,0 +1,100 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include "wst_sensor_config.h"
+#include "wst_events.h"
+
+#include <zephyr/kernel.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//
+// Sensor data client, modeled after Zephyr sensing subsystem clients.
+// Each client asks for its own interval of each sensor, hardware is sampled
+// once at the shortest interval requested and samples are fanned out to
+// clients as they become due for them.
+//
+typedef struct wst_sensor_client {
+	const char* name;
+	struct k_queue* queue;						// receives sensor messages
+	uint32_t interval_ms[WST_SENSOR_COUNT];		// requested intervals, 0 if not subscribed
+	int64_t next_ms[WST_SENSOR_COUNT];			// next delivery time of each sensor
+} wst_sensor_client_t;
+
+/**
+ * @brief Initializes client registry.
+ *
+ * @param[in] wakeup       semaphore given whenever requested intervals change
+ */
+void wst_sensor_client_init(struct k_sem* wakeup);
+
+/**
+ * @brief Registers sensor data client.
+ *
+ * Client is not subscribed to any sensor until it sets an interval.
+ * Sensor messages appended to the client queue are allocated from
+ * events_pool, and must be freed by the client.
+ *
+ * @param[in] client       client to register
+ * @param[in] name         client name
+ * @param[in] queue        client message queue
+ *
+ * @return 0 on success, -ENOMEM if CONFIG_WST_SENSOR_CLIENT_MAX clients
+ *         are already registered.
+ */
+int wst_sensor_client_open(wst_sensor_client_t* client, const char* name, struct k_queue* queue);
+
+/**
+ * @brief Requests sensor sampling interval for a client.
+ *
+ * Takes effect from the next acquisition. Must be called from a supervisor
+ * thread.
+ *
+ * @param[in] client       registered client
+ * @param[in] sensor       sensor index in the sensor configuration
+ * @param[in] interval_ms  requested interval, 0 to unsubscribe
+ *
+ * @return 0 on success, -EINVAL for unknown sensor.
+ */
+int wst_sensor_client_set_interval(wst_sensor_client_t* client, uint16_t sensor, uint32_t interval_ms);
+
+/**
+ * @brief Returns arbitrated sampling interval of a sensor.
+ *
+ * @param[in] sensor       sensor index in the sensor configuration
+ *
+ * @return Shortest interval requested by clients, 0 if no client subscribed.
+ */
+uint32_t wst_sensor_client_get_interval(uint16_t sensor);
+
+/**
+ * @brief Returns true once after any client interval changed.
+ */
+bool wst_sensor_client_intervals_changed(void);
+
+/**
+ * @brief Fans sensor message out to clients.
+ *
+ * Each client gets the values of the sensors it subscribed to and which
+ * are due for it, sensors read on a trigger or streamed are delivered
+ * regardless of the interval. Takes ownership of the message.
+ *
+ * @param[in] msg          sensor message allocated from events_pool
+ * @param[in] triggered    bit mask of sensors read on a trigger or streamed
+ */
+void wst_sensor_client_publish(wst_event_msg_t* msg, uint32_t triggered);
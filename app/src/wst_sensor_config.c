@@ -37,8 +37,25 @@ LOG_MODULE_REGISTER(wst_sensor_config);
 //
 // Declare iodevs for sensors RTIO
 //
-#define WST_DT_SENSOR_CHANNEL_ARRAY_DEFINE(node_id, prop, idx)	\
-	{.chan_type = DT_PROP_BY_IDX(node_id, prop, idx), .chan_idx = 0}
+#define WST_DT_SENSOR_CHANNEL_INDEX(node_id, idx)								\
+	COND_CODE_1(DT_NODE_HAS_PROP(node_id, channel_indices),						\
+		(DT_PROP_BY_IDX(node_id, channel_indices, idx)), (0))
+
+#define WST_DT_SENSOR_CHANNEL_ARRAY_DEFINE(node_id, prop, idx)					\
+	{																			\
+		.chan_type = DT_PROP_BY_IDX(node_id, prop, idx),						\
+		.chan_idx = WST_DT_SENSOR_CHANNEL_INDEX(node_id, idx)					\
+	}
+
+#define WST_DT_SENSOR_CHANNEL_INDICES_CHECK(_inst)								\
+	IF_ENABLED(DT_INST_NODE_HAS_PROP(_inst, channel_indices), (				\
+		BUILD_ASSERT(															\
+			DT_INST_PROP_LEN(_inst, channel_indices) ==							\
+			DT_INST_PROP_LEN(_inst, channel_types),								\
+			"channel-indices must match channel-types length");				\
+	))
+
+DT_INST_FOREACH_STATUS_OKAY(WST_DT_SENSOR_CHANNEL_INDICES_CHECK);
 
 
 #define WST_DT_READ_IODEV(_inst)												\
@@ -60,17 +77,183 @@ static struct rtio_iodev* iodevs[] = {
 	DT_INST_FOREACH_STATUS_OKAY(WST_DT_READ_IODEV_REFERENCE_DEFINE)
 };
 
+//
+// Declare iodevs for FIFO streaming sensors, NULL for polled sensors
+//
+#if defined(CONFIG_WST_SENSOR_STREAM)
+
+#define WST_DT_STREAM_IODEV(_inst)												\
+	IF_ENABLED(DT_INST_PROP(_inst, fifo_stream), (								\
+		SENSOR_DT_STREAM_IODEV(													\
+			_CONCAT(sensor_stream_iodev, _inst),								\
+			DT_PHANDLE(DT_DRV_INST(_inst), sensor_device),						\
+			{SENSOR_TRIG_FIFO_WATERMARK, SENSOR_STREAM_DATA_INCLUDE});			\
+	))
+
+DT_INST_FOREACH_STATUS_OKAY(WST_DT_STREAM_IODEV);
+
+#define WST_DT_STREAM_IODEV_REFERENCE_DEFINE(_inst)								\
+	COND_CODE_1(DT_INST_PROP(_inst, fifo_stream),								\
+		(_CONCAT(&sensor_stream_iodev, _inst)), (NULL)),
+
+#else
+
+#define WST_DT_STREAM_IODEV_REFERENCE_DEFINE(_inst)								\
+	NULL,
+
+#endif
+
+static struct rtio_iodev* stream_iodevs[] = {
+	DT_INST_FOREACH_STATUS_OKAY(WST_DT_STREAM_IODEV_REFERENCE_DEFINE)
+};
+
 //
 // Declare sensors info
 //
 #define WST_DT_SENSOR_DEVICE_DEFINE(_inst)										\
 	DEVICE_DT_GET(DT_PHANDLE(DT_DRV_INST(_inst), sensor_device))
 
+#define WST_DT_SENSOR_I2C_BUS_DEFINE(_inst)										\
+	COND_CODE_1(DT_ON_BUS(DT_INST_PHANDLE(_inst, sensor_device), i2c),			\
+		(DEVICE_DT_GET(DT_BUS(DT_INST_PHANDLE(_inst, sensor_device)))), (NULL))
+
+#define WST_DT_SENSOR_POLLING_PERIOD(_inst)										\
+	DT_INST_PROP_OR(_inst, polling_interval_ms,									\
+		DT_PROP(DT_INST_PARENT(_inst), polling_interval_ms))
+
+#define WST_DT_SENSOR_DECIMATION_DEFINE(_inst)									\
+	IF_ENABLED(DT_INST_NODE_HAS_PROP(_inst, channel_decimation), (				\
+		BUILD_ASSERT(															\
+			DT_INST_PROP_LEN(_inst, channel_decimation) ==						\
+			DT_INST_PROP_LEN(_inst, channel_types),								\
+			"channel-decimation must match channel-types length");				\
+		static const uint16_t _CONCAT(sensor_decimation, _inst)[] =				\
+			DT_INST_PROP(_inst, channel_decimation);							\
+	))
+
+#define WST_DT_SENSOR_DECIMATION_REFERENCE(_inst)								\
+	COND_CODE_1(DT_INST_NODE_HAS_PROP(_inst, channel_decimation),				\
+		(_CONCAT(sensor_decimation, _inst)), (NULL))
+
+DT_INST_FOREACH_STATUS_OKAY(WST_DT_SENSOR_DECIMATION_DEFINE);
+
+#define WST_DT_SENSOR_CALIBRATION_DEFINE(_inst)									\
+	IF_ENABLED(DT_INST_NODE_HAS_PROP(_inst, channel_calibration), (				\
+		BUILD_ASSERT(															\
+			DT_INST_PROP_LEN(_inst, channel_calibration) ==						\
+			2 * DT_INST_PROP_LEN(_inst, channel_types),							\
+			"channel-calibration must have a pair for each of channel-types");	\
+		static const int32_t _CONCAT(sensor_calibration, _inst)[] =				\
+			DT_INST_PROP(_inst, channel_calibration);							\
+	))
+
+#define WST_DT_SENSOR_CALIBRATION_REFERENCE(_inst)								\
+	COND_CODE_1(DT_INST_NODE_HAS_PROP(_inst, channel_calibration),				\
+		(_CONCAT(sensor_calibration, _inst)), (NULL))
+
+DT_INST_FOREACH_STATUS_OKAY(WST_DT_SENSOR_CALIBRATION_DEFINE);
+
+#define WST_DT_SENSOR_DEADBAND_DEFINE(_inst)									\
+	IF_ENABLED(DT_INST_NODE_HAS_PROP(_inst, channel_deadband), (				\
+		BUILD_ASSERT(															\
+			DT_INST_PROP_LEN(_inst, channel_deadband) ==						\
+			DT_INST_PROP_LEN(_inst, channel_types),								\
+			"channel-deadband must match channel-types length");				\
+		static const int32_t _CONCAT(sensor_deadband, _inst)[] =				\
+			DT_INST_PROP(_inst, channel_deadband);								\
+	))
+
+#define WST_DT_SENSOR_DEADBAND_REFERENCE(_inst)									\
+	COND_CODE_1(DT_INST_NODE_HAS_PROP(_inst, channel_deadband),					\
+		(_CONCAT(sensor_deadband, _inst)), (NULL))
+
+DT_INST_FOREACH_STATUS_OKAY(WST_DT_SENSOR_DEADBAND_DEFINE);
+
+#define WST_DT_SENSOR_DERIVED_DEFINE(_inst)										\
+	IF_ENABLED(DT_INST_NODE_HAS_PROP(_inst, derived_channels), (				\
+		static const int32_t _CONCAT(sensor_derived, _inst)[] =					\
+			DT_INST_PROP(_inst, derived_channels);								\
+	))																			\
+	IF_ENABLED(DT_INST_NODE_HAS_PROP(_inst, derived_deadband), (				\
+		BUILD_ASSERT(															\
+			DT_INST_PROP_LEN(_inst, derived_deadband) ==						\
+			DT_INST_PROP_LEN_OR(_inst, derived_channels, 0),					\
+			"derived-deadband must match derived-channels length");				\
+		static const int32_t _CONCAT(sensor_derived_deadband, _inst)[] =		\
+			DT_INST_PROP(_inst, derived_deadband);								\
+	))
+
+#define WST_DT_SENSOR_DERIVED_REFERENCE(_inst)									\
+	COND_CODE_1(DT_INST_NODE_HAS_PROP(_inst, derived_channels),					\
+		(_CONCAT(sensor_derived, _inst)), (NULL))
+
+#define WST_DT_SENSOR_DERIVED_DEADBAND_REFERENCE(_inst)							\
+	COND_CODE_1(DT_INST_NODE_HAS_PROP(_inst, derived_deadband),					\
+		(_CONCAT(sensor_derived_deadband, _inst)), (NULL))
+
+DT_INST_FOREACH_STATUS_OKAY(WST_DT_SENSOR_DERIVED_DEFINE);
+
+#define WST_DT_SENSOR_ATTRIBUTES_DEFINE(_inst)									\
+	IF_ENABLED(DT_INST_NODE_HAS_PROP(_inst, attributes), (						\
+		BUILD_ASSERT(															\
+			(DT_INST_PROP_LEN(_inst, attributes) % 4) == 0,						\
+			"attributes must be <chan attr val1 val2> quadruples");				\
+		static const wst_sensor_attr_t _CONCAT(sensor_attributes, _inst)[] =	\
+			DT_INST_PROP(_inst, attributes);									\
+	))
+
+#define WST_DT_SENSOR_ATTRIBUTES_REFERENCE(_inst)								\
+	COND_CODE_1(DT_INST_NODE_HAS_PROP(_inst, attributes),						\
+		(_CONCAT(sensor_attributes, _inst)), (NULL))
+
+#define WST_DT_SENSOR_ATTRIBUTE_COUNT(_inst)										\
+	(DT_INST_PROP_LEN_OR(_inst, attributes, 0) / 4)
+
+DT_INST_FOREACH_STATUS_OKAY(WST_DT_SENSOR_ATTRIBUTES_DEFINE);
+
+#define WST_DT_SENSOR_GROUP_CHECK(_inst)										\
+	BUILD_ASSERT(																\
+		WST_DT_SENSOR_GROUP(DT_DRV_INST(_inst)) < CONFIG_WST_SENSOR_GROUP_COUNT,\
+		"acquisition-group must be less than CONFIG_WST_SENSOR_GROUP_COUNT");
+
+DT_INST_FOREACH_STATUS_OKAY(WST_DT_SENSOR_GROUP_CHECK);
+
+#define WST_DT_SENSOR_BURST_MAX													\
+	COND_CODE_1(CONFIG_WST_SENSOR_BURST, (CONFIG_WST_SENSOR_BURST_MAX), (1))
+
+#define WST_DT_SENSOR_BURST_CHECK(_inst)										\
+	BUILD_ASSERT(																\
+		DT_INST_PROP(_inst, burst_count) <= WST_DT_SENSOR_BURST_MAX,			\
+		"burst-count requires CONFIG_WST_SENSOR_BURST and must not exceed "		\
+		"CONFIG_WST_SENSOR_BURST_MAX");
+
+DT_INST_FOREACH_STATUS_OKAY(WST_DT_SENSOR_BURST_CHECK);
+
 #define WST_DT_SENSOR_INFO(_inst)												\
 	static const wst_sensor_info_t _CONCAT(sensor, _inst) = {					\
 		.sensor_device = WST_DT_SENSOR_DEVICE_DEFINE(_inst),					\
+		.i2c_bus = WST_DT_SENSOR_I2C_BUS_DEFINE(_inst),							\
 		.name = DT_NODE_FULL_NAME(DT_DRV_INST(_inst)),							\
 		.friendly_name = DT_PROP(DT_DRV_INST(_inst), friendly_name),			\
+		.polling_period_ms = WST_DT_SENSOR_POLLING_PERIOD(_inst),				\
+		.channel_decimation = WST_DT_SENSOR_DECIMATION_REFERENCE(_inst),		\
+		.channel_calibration = WST_DT_SENSOR_CALIBRATION_REFERENCE(_inst),		\
+		.channel_deadband = WST_DT_SENSOR_DEADBAND_REFERENCE(_inst),			\
+		.fifo_stream = DT_INST_PROP(_inst, fifo_stream),						\
+		.acquisition_group = WST_DT_SENSOR_GROUP(DT_DRV_INST(_inst)),			\
+		.conversion_time_ms = DT_INST_PROP_OR(_inst, conversion_time_ms, 0),	\
+		.burst_count = DT_INST_PROP(_inst, burst_count),						\
+		.burst_filter = DT_INST_PROP(_inst, burst_filter),						\
+		.derived_channels = WST_DT_SENSOR_DERIVED_REFERENCE(_inst),				\
+		.derived_deadband = WST_DT_SENSOR_DERIVED_DEADBAND_REFERENCE(_inst),	\
+		.derived_channel_count = DT_INST_PROP_LEN_OR(_inst, derived_channels, 0),\
+		.altitude_m = DT_INST_PROP(_inst, altitude_m),							\
+		.trigger_type = DT_INST_PROP_OR(_inst, trigger_type,					\
+			WST_SENSOR_TRIGGER_NONE),											\
+		.trigger_channel = DT_INST_PROP_OR(_inst, trigger_channel,				\
+			DT_INST_PROP_BY_IDX(_inst, channel_types, 0)),						\
+		.attributes = WST_DT_SENSOR_ATTRIBUTES_REFERENCE(_inst),				\
+		.attribute_count = WST_DT_SENSOR_ATTRIBUTE_COUNT(_inst),				\
 		.channel_type_count = DT_PROP_LEN(DT_DRV_INST(_inst), channel_types),	\
 		.channel_types = DT_PROP(DT_DRV_INST(_inst), channel_types),			\
 	};
@@ -84,12 +267,25 @@ static const wst_sensor_info_t* sensors[] = {
 	DT_INST_FOREACH_STATUS_OKAY(WST_DT_SENSOR_INFO_REFERENCE_DEFINE)
 };
 
+//
+// Declare sensors decode plans, built at init
+//
+static wst_sensor_plan_t plans[ARRAY_SIZE(sensors)];
+static wst_sensor_channel_plan_t channel_plans[WST_SENSOR_CHANNEL_COUNT];
+
+//
+// Protects channel calibration against runtime updates
+//
+static struct k_spinlock calibration_lock;
+
 //
 // Declare sensors configuration
 //
 static const wst_sensor_config_t sensor_config = {
 	.iodevs = iodevs,
+	.stream_iodevs = stream_iodevs,
 	.sensors = sensors,
+	.plans = plans,
 	.sensor_count = ARRAY_SIZE(sensors),
 	.polling_period_ms = DT_PROP(DT_NODELABEL(sensor_config), polling_interval_ms)
 };
@@ -99,34 +295,253 @@ static int get_sensor_count(void)
 	return ARRAY_SIZE(sensors);
 }
 
-static void print_sensor_info(const wst_sensor_info_t* sensor)
+static void print_sensor_info(const wst_sensor_info_t* sensor, const struct sensor_read_config* read_config)
 {
 	LOG_INF("Sensor '%s' found on [%s] device",
 		sensor->name,
 		sensor->sensor_device->name
 	);
 
-	LOG_INF("Supported channels on %s:", sensor->friendly_name);
+	LOG_INF("Supported channels on %s, polled every %u ms by group %u:",
+		sensor->friendly_name,
+		sensor->polling_period_ms,
+		sensor->acquisition_group
+	);
 
 	for (int i = 0; i < sensor->channel_type_count; i++) {
-		LOG_INF("   %s", wst_sensor_get_channel_name(sensor->channel_types[i]));
+		LOG_INF("   %s %u, decimation %u",
+			wst_sensor_get_channel_name(read_config->channels[i].chan_type),
+			read_config->channels[i].chan_idx,
+			sensor->channel_decimation ? sensor->channel_decimation[i] : 1
+		);
+	}
+
+	for (int i = 0; i < sensor->derived_channel_count; i++) {
+		LOG_INF("   %s, derived",
+			wst_sensor_get_channel_name(sensor->derived_channels[i])
+		);
+	}
+}
+
+static int set_channel_calibration(
+	wst_sensor_channel_plan_t* channel,
+	int32_t gain_ppm,
+	int32_t offset_micro)
+{
+	wst_sensor_calibration_t calibration;
+
+	int rc = wst_sensor_calibration_init(&calibration, gain_ppm, offset_micro);
+	if (rc != 0) {
+		LOG_ERR("%s calibration gain %d ppm out of range",
+			wst_sensor_get_channel_name(channel->spec.chan_type),
+			gain_ppm
+		);
+		return rc;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&calibration_lock);
+
+	channel->calibration = calibration;
+	channel->calibrated = (gain_ppm != 1000000) || (offset_micro != 0);
+
+	k_spin_unlock(&calibration_lock, key);
+
+	if (channel->calibrated) {
+		LOG_INF("%s %u calibration gain %d ppm, offset %d micro",
+			wst_sensor_get_channel_name(channel->spec.chan_type),
+			channel->spec.chan_idx,
+			gain_ppm,
+			offset_micro
+		);
 	}
+	return 0;
+}
+
+static void build_sensor_plans(void)
+{
+	uint16_t slot = 0;
+
+	for (int i = 0; i < get_sensor_count(); i++) {
+		const wst_sensor_info_t* sensor = sensors[i];
+		const struct sensor_read_config* read_config =
+			(const struct sensor_read_config *) iodevs[i]->data;
+
+		wst_sensor_plan_t* plan = &plans[i];
+		wst_sensor_channel_plan_t* channels = &channel_plans[slot];
+
+		int rc = sensor_get_decoder(sensor->sensor_device, &plan->decoder);
+		if (rc != 0) {
+			LOG_ERR("sensor_get_decoder for %s failed %d", sensor->name, rc);
+			plan->decoder = NULL;
+		}
+
+		const struct sensor_driver_api* api = sensor->sensor_device->api;
+
+		for (size_t j = 0; j < read_config->count; j++) {
+			wst_sensor_channel_plan_t* channel = &channels[j];
+
+			channel->spec = read_config->channels[j];
+			channel->format = wst_sensor_get_channel_format(channel->spec.chan_type);
+			channel->payload_type = wst_sensor_get_channel_payload_type(channel->spec.chan_type);
+			channel->decimation = sensor->channel_decimation ?
+				MAX(sensor->channel_decimation[j], 1) : 1;
+			channel->slot = slot++;
+			channel->sensor = (uint8_t) i;
+
+			if (channel->spec.chan_idx && !api->submit) {
+				// sensor_submit_fallback() fetches channels by type only
+				LOG_WRN("%s %s %u reads index 0, driver has no RTIO submit",
+					sensor->name,
+					wst_sensor_get_channel_name(channel->spec.chan_type),
+					channel->spec.chan_idx
+				);
+			}
+
+			set_channel_calibration(
+				channel,
+				sensor->channel_calibration ? sensor->channel_calibration[2 * j] : 1000000,
+				sensor->channel_calibration ? sensor->channel_calibration[2 * j + 1] : 0
+			);
+		}
+
+		plan->channels = channels;
+		plan->channel_count = read_config->count;
+	}
+
+	// Derived channels follow physical channels of all sensors
+	for (int i = 0; i < get_sensor_count(); i++) {
+		const wst_sensor_info_t* sensor = sensors[i];
+
+		wst_sensor_plan_t* plan = &plans[i];
+		wst_sensor_channel_plan_t* channels = &channel_plans[slot];
+
+		for (size_t j = 0; j < sensor->derived_channel_count; j++) {
+			wst_sensor_channel_plan_t* channel = &channels[j];
+
+			channel->spec.chan_type = (uint16_t) sensor->derived_channels[j];
+			channel->spec.chan_idx = 0;
+			channel->format = wst_sensor_format_scalar;
+			channel->payload_type = wst_sensor_get_channel_payload_type(channel->spec.chan_type);
+			channel->decimation = 1;
+			channel->slot = slot++;
+			channel->sensor = (uint8_t) i;
+			channel->calibrated = false;
+		}
+
+		plan->derived = channels;
+		plan->derived_count = sensor->derived_channel_count;
+	}
+}
+
+int wst_sensor_set_calibration(uint16_t slot, int32_t gain_ppm, int32_t offset_micro)
+{
+	if (slot >= WST_SENSOR_CHANNEL_COUNT) {
+		return -EINVAL;
+	}
+	return set_channel_calibration(&channel_plans[slot], gain_ppm, offset_micro);
+}
+
+bool wst_sensor_get_calibration(
+	const wst_sensor_channel_plan_t* channel,
+	wst_sensor_calibration_t* calibration)
+{
+	k_spinlock_key_t key = k_spin_lock(&calibration_lock);
+
+	bool calibrated = channel->calibrated;
+	*calibration = channel->calibration;
+
+	k_spin_unlock(&calibration_lock, key);
+
+	return calibrated;
+}
+
+int wst_sensor_set_attributes(const wst_sensor_info_t* sensor)
+{
+	int result = 0;
+
+	for (int i = 0; i < sensor->attribute_count; i++) {
+		const wst_sensor_attr_t* attribute = &sensor->attributes[i];
+		const struct sensor_value value = {
+			.val1 = attribute->val1,
+			.val2 = attribute->val2
+		};
+
+		int rc = sensor_attr_set(
+			sensor->sensor_device,
+			(enum sensor_channel) attribute->chan,
+			(enum sensor_attribute) attribute->attr,
+			&value
+		);
+
+		if (rc != 0) {
+			// Keep driver defaults for this attribute, try the rest
+			LOG_ERR("%s attribute %d of %s set failed %d",
+				sensor->name,
+				attribute->attr,
+				wst_sensor_get_channel_name(attribute->chan),
+				rc
+			);
+			result = rc;
+		} else {
+			LOG_INF("   %s attribute %d = %d.%06d",
+				wst_sensor_get_channel_name(attribute->chan),
+				attribute->attr,
+				attribute->val1,
+				attribute->val2
+			);
+		}
+	}
+
+	return result;
+}
+
+int32_t wst_sensor_get_deadband(uint16_t slot)
+{
+	for (int i = 0; i < get_sensor_count(); i++) {
+		const wst_sensor_info_t* sensor = sensors[i];
+
+		if (slot < sensor->channel_type_count) {
+			return sensor->channel_deadband ? sensor->channel_deadband[slot] : 0;
+		}
+		slot -= sensor->channel_type_count;
+	}
+
+	for (int i = 0; i < get_sensor_count(); i++) {
+		const wst_sensor_info_t* sensor = sensors[i];
+
+		if (slot < sensor->derived_channel_count) {
+			return sensor->derived_deadband ? sensor->derived_deadband[slot] : 0;
+		}
+		slot -= sensor->derived_channel_count;
+	}
+	return 0;
+}
+
+uint8_t wst_sensor_get_slot_sensor(uint16_t slot)
+{
+	__ASSERT_NO_MSG(slot < WST_SENSOR_CHANNEL_COUNT);
+
+	return channel_plans[slot].sensor;
 }
 
 const wst_sensor_config_t* wst_sensor_get_config(void)
 {
-	LOG_INF("Sensor polling period: %d ms", sensor_config.polling_period_ms);
+	LOG_INF("Default sensor polling period: %d ms", sensor_config.polling_period_ms);
 
 	for (int i = 0; i < get_sensor_count(); i++)
 	{
+		print_sensor_info(sensors[i], (const struct sensor_read_config *) iodevs[i]->data);
+
 		if (!device_is_ready(sensors[i]->sensor_device)) {
+			// Not fatal, sensor thread re-probes the device in background,
+			// and applies attributes once it is ready
 			LOG_ERR("device %s not ready.", sensors[i]->sensor_device->name);
-			k_oops();
 		} else {
-			print_sensor_info(sensors[i]);
+			wst_sensor_set_attributes(sensors[i]);
 		}
 	}
 
+	build_sensor_plans();
 
 	return &sensor_config;
 }
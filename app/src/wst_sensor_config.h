@@ -15,25 +15,202 @@
 
 #pragma once
 
+#include "wst_sensor_utils.h"
+
 #include <zephyr/rtio/rtio.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/sensor.h>
 
 #include <stdint.h>
 
+//
+// Total number of channels declared by all enabled wst,sensor nodes,
+// derived channels included, known at build time to size sensor messages
+// without heap churn.
+//
+#define WST_DT_SENSOR_CHANNEL_COUNT_ADD(node_id)	\
+	DT_PROP_LEN(node_id, channel_types) + DT_PROP_LEN_OR(node_id, derived_channels, 0) +
+
+#define WST_SENSOR_CHANNEL_COUNT													\
+	(DT_FOREACH_STATUS_OKAY(wst_sensor, WST_DT_SENSOR_CHANNEL_COUNT_ADD) 0)
+
+//
+// Number of enabled wst,sensor nodes
+//
+#define WST_SENSOR_COUNT	DT_NUM_INST_STATUS_OKAY(wst_sensor)
+
+//
+// Encoded buffer size of a single sensor read, known at build time to size
+// the RTIO memory pool. Unless overridden by encoded-buffer-size, it is
+// estimated for the generic encoding of sensor_submit_fallback(): a header,
+// then a channel spec and a q31 sample for every axis of every channel.
+//
+#define WST_DT_SENSOR_AXIS_COUNT_ADD(node_id, prop, idx)							\
+	(((DT_PROP_BY_IDX(node_id, prop, idx) == SENSOR_CHAN_ACCEL_XYZ) ||			\
+	  (DT_PROP_BY_IDX(node_id, prop, idx) == SENSOR_CHAN_GYRO_XYZ) ||			\
+	  (DT_PROP_BY_IDX(node_id, prop, idx) == SENSOR_CHAN_MAGN_XYZ)) ? 3 : 1) +
+
+#define WST_DT_SENSOR_ENCODED_SIZE(node_id)											\
+	DT_PROP_OR(node_id, encoded_buffer_size,										\
+		(sizeof(struct sensor_data_generic_header) +								\
+		 (DT_FOREACH_PROP_ELEM(node_id, channel_types,								\
+			WST_DT_SENSOR_AXIS_COUNT_ADD) 0) *										\
+		 (sizeof(struct sensor_chan_spec) + sizeof(q31_t))))
+
+//
+// Acquisition group of a wst,sensor node, sensors of different groups
+// are acquired in parallel
+//
+#define WST_DT_SENSOR_GROUP(node_id)												\
+	DT_PROP_OR(node_id, acquisition_group, 0)
+
+//
+// Number of enabled wst,sensor nodes in an acquisition group
+//
+#define WST_DT_SENSOR_GROUP_SENSOR_COUNT_ADD(node_id, group)						\
+	((WST_DT_SENSOR_GROUP(node_id) == (group)) ? 1 : 0) +
+
+#define WST_SENSOR_GROUP_SENSOR_COUNT(group)										\
+	(DT_FOREACH_STATUS_OKAY_VARGS(wst_sensor,										\
+		WST_DT_SENSOR_GROUP_SENSOR_COUNT_ADD, group) 0)
+
+//
+// Number of memory blocks of the given size needed to hold an encoded
+// buffer of every enabled wst,sensor node of a group at the same time
+//
+#define WST_DT_SENSOR_GROUP_BLOCK_COUNT_ADD(node_id, group, block_size)			\
+	((WST_DT_SENSOR_GROUP(node_id) == (group)) ?									\
+		DIV_ROUND_UP(WST_DT_SENSOR_ENCODED_SIZE(node_id), block_size) : 0) +
+
+#define WST_SENSOR_GROUP_BLOCK_COUNT(group, block_size)								\
+	(DT_FOREACH_STATUS_OKAY_VARGS(wst_sensor,										\
+		WST_DT_SENSOR_GROUP_BLOCK_COUNT_ADD, group, block_size) 0)
+
+//
+// Sensor attribute applied at init, laid out as a quadruple of the
+// devicetree attributes property
+//
+typedef struct wst_sensor_attr {
+	int32_t chan;
+	int32_t attr;
+	int32_t val1;
+	int32_t val2;
+} wst_sensor_attr_t;
+
+//
+// Trigger type of sensors without trigger-type
+//
+#define WST_SENSOR_TRIGGER_NONE		(-1)
+
 typedef struct wst_sensor_info {
 	const struct device* sensor_device;
+	const struct device* i2c_bus;		// I2C bus of the sensor device, NULL if not on I2C
 	const char *name;
 	const char *friendly_name;
+	const uint32_t polling_period_ms;
+	const uint16_t* channel_decimation;
+	const int32_t* channel_calibration;	// <gain_ppm offset_micro> pairs, NULL if not calibrated
+	const int32_t* channel_deadband;	// in thousandths of the channel unit, NULL if sent on every uplink
+	const bool fifo_stream;
+	const uint8_t acquisition_group;
+	const uint16_t conversion_time_ms;
+	const uint8_t burst_count;			// reads per poll, 1 if not oversampled
+	const uint8_t burst_filter;			// WST_FILTER_* stages of the burst
+	const int32_t* derived_channels;	// WST_CHANNEL_TYPE_* of derived channels, NULL if none
+	const int32_t* derived_deadband;	// in thousandths of the channel unit, NULL if sent on every uplink
+	const uint8_t derived_channel_count;
+	const int16_t altitude_m;			// station elevation for sea level pressure
+	const int16_t trigger_type;		// sensor trigger type, WST_SENSOR_TRIGGER_NONE if polled only
+	const int16_t trigger_channel;
+	const wst_sensor_attr_t* attributes;
+	const uint16_t attribute_count;
 	const int channel_type_count;
 	const int32_t channel_types[];
 } wst_sensor_info_t;
 
 
+//
+// Decode plan of a single sensor channel, precomputed at init
+//
+typedef struct wst_sensor_channel_plan {
+	struct sensor_chan_spec spec;
+	wst_sensor_format_t format;
+	uint16_t slot;				// index of the channel among all configured channels
+	uint8_t sensor;				// index of the sensor the channel belongs to
+	uint16_t decimation;		// channel is reported on every N-th read
+	uint8_t payload_type;		// target payload type, WST_SENSOR_PAYLOAD_NONE if not encoded
+	bool calibrated;			// calibration differs from identity
+	wst_sensor_calibration_t calibration;
+} wst_sensor_channel_plan_t;
+
+//
+// Decode plan of a sensor, precomputed at init
+//
+typedef struct wst_sensor_plan {
+	const struct sensor_decoder_api* decoder;
+	uint16_t channel_count;
+	const wst_sensor_channel_plan_t* channels;
+	uint16_t derived_count;
+	const wst_sensor_channel_plan_t* derived;	// derived channels, slots after all physical channels
+} wst_sensor_plan_t;
+
 typedef struct wst_sensor_config {
 	uint16_t sensor_count;
 	uint32_t polling_period_ms;
 
 	struct rtio_iodev** iodevs;
+	struct rtio_iodev** stream_iodevs;
 	const wst_sensor_info_t** sensors;
+	const wst_sensor_plan_t* plans;
 } wst_sensor_config_t;
 
 const wst_sensor_config_t* wst_sensor_get_config(void);
+
+int wst_sensor_set_attributes(const wst_sensor_info_t* sensor);
+
+/**
+ * @brief Overrides calibration of a channel at runtime.
+ *
+ * Takes effect from the next decoded buffer. Must be called from
+ * a supervisor thread.
+ *
+ * @param[in] slot         index of the channel among all configured channels
+ * @param[in] gain_ppm     gain in parts per million, 1000000 is unity gain
+ * @param[in] offset_micro offset in millionths of the channel unit
+ *
+ * @return 0 on success, -EINVAL for unknown slot, -ERANGE for gain out of range.
+ */
+int wst_sensor_set_calibration(uint16_t slot, int32_t gain_ppm, int32_t offset_micro);
+
+/**
+ * @brief Returns consistent copy of a channel calibration.
+ *
+ * @param[in]  channel     channel decode plan
+ * @param[out] calibration channel calibration
+ *
+ * @return true if the channel is calibrated, false for identity calibration.
+ */
+bool wst_sensor_get_calibration(
+	const wst_sensor_channel_plan_t* channel,
+	wst_sensor_calibration_t* calibration);
+
+/**
+ * @brief Returns devicetree report-on-change threshold of a channel.
+ *
+ * @param[in]  slot        index of the channel among all configured channels
+ *
+ * @return Threshold in thousandths of the channel unit, 0 if the channel
+ *         is sent on every uplink.
+ */
+int32_t wst_sensor_get_deadband(uint16_t slot);
+
+/**
+ * @brief Returns the sensor a channel belongs to.
+ *
+ * Covers physical and derived channels.
+ *
+ * @param[in]  slot        index of the channel among all configured channels
+ *
+ * @return Sensor index in the sensor configuration.
+ */
+uint8_t wst_sensor_get_slot_sensor(uint16_t slot);
@@ -0,0 +1,269 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "wst_sensor_decode.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/drivers/sensor_data_types.h>
+#include <zephyr/dsp/print_format.h>
+
+
+#define LOG_LEVEL CONFIG_LOG_DEFAULT_LEVEL
+//#define LOG_LEVEL LOG_LEVEL_DBG
+LOG_MODULE_REGISTER(wst_sensor_decode);
+
+//
+// Decoder output for a batch of frames of a single channel
+//
+typedef union wst_sensor_decode_batch {
+	struct sensor_q31_data q31_data;
+	struct sensor_three_axis_data q31_3d_data;
+	uint8_t raw[sizeof(struct sensor_three_axis_data) +
+		(WST_SENSOR_DECODE_BATCH - 1) * sizeof(struct sensor_three_axis_sample_data)];
+} wst_sensor_decode_batch_t;
+
+static bool is_multi_frame(const wst_sensor_channel_plan_t* channel)
+{
+	return (wst_sensor_format_scalar == channel->format) ||
+		(wst_sensor_format_3d_vector == channel->format);
+}
+
+static uint16_t get_frame_count(
+	const wst_sensor_plan_t* plan,
+	const wst_sensor_channel_plan_t* channel,
+	const uint8_t* buf)
+{
+	uint16_t frames = 1;
+
+	if (is_multi_frame(channel) && plan->decoder->get_frame_count) {
+		if (plan->decoder->get_frame_count(buf, channel->spec, &frames) != 0) {
+			frames = 1;
+		}
+	}
+	return frames;
+}
+
+static void set_value_info(wst_sensor_value_t* value, const wst_sensor_channel_plan_t* channel)
+{
+	value->spec = channel->spec;
+	value->slot = channel->slot;
+	value->payload_type = channel->payload_type;
+}
+
+static void calibrate_value(
+	wst_sensor_value_t* value,
+	const wst_sensor_channel_plan_t* channel,
+	const wst_sensor_calibration_t* calibration)
+{
+	if (wst_sensor_format_scalar == channel->format) {
+		struct sensor_q31_sample_data* reading = &value->data.q31_data.readings[0];
+
+		reading->value = wst_sensor_calibrate_q31(calibration, reading->value, value->data.q31_data.shift);
+	} else {
+		struct sensor_three_axis_sample_data* reading = &value->data.q31_3d_data.readings[0];
+		int8_t shift = value->data.q31_3d_data.shift;
+
+		reading->x = wst_sensor_calibrate_q31(calibration, reading->x, shift);
+		reading->y = wst_sensor_calibrate_q31(calibration, reading->y, shift);
+		reading->z = wst_sensor_calibrate_q31(calibration, reading->z, shift);
+	}
+}
+
+static void split_batch(
+	wst_sensor_value_t* values,
+	const wst_sensor_channel_plan_t* channel,
+	const wst_sensor_calibration_t* calibration,
+	const wst_sensor_decode_batch_t* batch,
+	uint16_t frames)
+{
+	// Each frame becomes a single reading value with its own timestamp
+	for (uint16_t i = 0; i < frames; i++) {
+		wst_sensor_value_t* value = &values[i];
+
+		set_value_info(value, channel);
+
+		if (wst_sensor_format_scalar == channel->format) {
+			struct sensor_q31_data* out = &value->data.q31_data;
+
+			out->header.base_timestamp_ns =
+				batch->q31_data.header.base_timestamp_ns +
+				batch->q31_data.readings[i].timestamp_delta;
+			out->header.reading_count = 1;
+			out->shift = batch->q31_data.shift;
+			out->readings[0] = batch->q31_data.readings[i];
+			out->readings[0].timestamp_delta = 0;
+		} else {
+			struct sensor_three_axis_data* out = &value->data.q31_3d_data;
+
+			out->header.base_timestamp_ns =
+				batch->q31_3d_data.header.base_timestamp_ns +
+				batch->q31_3d_data.readings[i].timestamp_delta;
+			out->header.reading_count = 1;
+			out->shift = batch->q31_3d_data.shift;
+			out->readings[0] = batch->q31_3d_data.readings[i];
+			out->readings[0].timestamp_delta = 0;
+		}
+
+		// Calibrate as values are written out
+		if (calibration) {
+			calibrate_value(value, channel, calibration);
+		}
+	}
+}
+
+static int decode_channel(
+	const wst_sensor_plan_t* plan,
+	const wst_sensor_channel_plan_t* channel,
+	const uint8_t* buf,
+	wst_sensor_value_t* values,
+	uint16_t max_count)
+{
+	// Frame iterator of the channel we are decoding
+	uint32_t fit = 0;
+	uint16_t count = 0;
+	int rc;
+
+	if (!is_multi_frame(channel)) {
+		// Single frame, decode straight into the value
+		rc = plan->decoder->decode(buf, channel->spec, &fit, 1, &values[0].data);
+		if (rc > 0) {
+			set_value_info(&values[0], channel);
+		}
+		return rc;
+	}
+
+	uint16_t frames = MIN(get_frame_count(plan, channel, buf), max_count);
+
+	// Calibration is taken once for all frames of the buffer
+	wst_sensor_calibration_t calibration;
+	bool calibrated = wst_sensor_get_calibration(channel, &calibration);
+
+	while (count < frames) {
+		wst_sensor_decode_batch_t batch;
+
+		rc = plan->decoder->decode(
+			buf,
+			channel->spec,
+			&fit,
+			MIN(frames - count, WST_SENSOR_DECODE_BATCH),
+			&batch
+		);
+
+		if (rc < 0) {
+			// Report failure only if nothing was decoded
+			return count ? count : rc;
+		}
+
+		if (rc == 0) {
+			// No more frames
+			break;
+		}
+
+		split_batch(values + count, channel, calibrated ? &calibration : NULL, &batch, (uint16_t) rc);
+		count += (uint16_t) rc;
+	}
+
+	return count;
+}
+
+static void log_value(
+	const wst_sensor_channel_plan_t* channel,
+	const wst_sensor_value_t* value,
+	uint16_t frames)
+{
+	switch (channel->format) {
+
+		case wst_sensor_format_scalar:
+			LOG_DBG("%s channel %u, frames - %u, value - %" PRIsensor_q31_data,
+				wst_sensor_get_channel_name(value->spec.chan_type),
+				value->spec.chan_idx,
+				frames,
+				PRIsensor_q31_data_arg(value->data.q31_data, 0)
+			);
+			break;
+
+		case wst_sensor_format_3d_vector:
+			LOG_DBG("%s channel %u, frames - %u, value - %" PRIsensor_three_axis_data,
+				wst_sensor_get_channel_name(value->spec.chan_type),
+				value->spec.chan_idx,
+				frames,
+				PRIsensor_three_axis_data_arg(value->data.q31_3d_data, 0)
+			);
+			break;
+
+		case wst_sensor_format_occurence:
+		case wst_sensor_format_byte_data:
+		case wst_sensor_format_uint64_data:
+		default:
+			break;
+	};
+}
+
+int wst_sensor_decode(
+	const wst_sensor_plan_t* plan,
+	uint32_t reads,
+	const uint8_t* buf,
+	wst_sensor_value_t* values,
+	uint16_t max_count,
+	uint32_t* errors)
+{
+	uint16_t count = 0;
+
+	*errors = 0;
+
+	if (!plan->decoder) {
+		return -ENOTSUP;
+	}
+
+	for (size_t i = 0; (i < plan->channel_count) && (count < max_count); i++) {
+
+		const wst_sensor_channel_plan_t* channel = &plan->channels[i];
+
+		if ((reads % channel->decimation) != 0) {
+			continue;
+		}
+
+		int rc = decode_channel(plan, channel, buf, values + count, max_count - count);
+
+		if (rc < 0) {
+			// In case of failure, fail gracefully,
+			// and try next channel, if any.
+			LOG_WRN("sensor decoding failed %d", rc);
+			(*errors)++;
+		} else if (rc > 0) {
+			log_value(channel, &values[count], (uint16_t) rc);
+			count += (uint16_t) rc;
+		}
+	}
+	return (int) count;
+}
+
+uint16_t wst_sensor_decode_get_count(
+	const wst_sensor_plan_t* plan,
+	const uint8_t* buf)
+{
+	uint16_t count = 0;
+
+	if (!plan->decoder) {
+		return 0;
+	}
+
+	for (size_t i = 0; i < plan->channel_count; i++) {
+		count += get_frame_count(plan, &plan->channels[i], buf);
+	}
+	return count;
+}
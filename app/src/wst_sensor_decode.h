@@ -0,0 +1,61 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include "wst_sensor_config.h"
+#include "wst_events.h"
+
+#include <stdint.h>
+
+//
+// Maximum number of frames decoded by a single decoder call
+//
+#define WST_SENSOR_DECODE_BATCH		(8)
+
+/**
+ * @brief Decodes sensor data buffer according to the sensor decode plan.
+ *
+ * Every frame of every due channel found in the buffer is decoded in
+ * batches and written to consecutive values, one frame per value.
+ *
+ * @param[in]  plan        sensor decode plan
+ * @param[in]  reads       sensor reads counter, drives channel decimation
+ * @param[in]  buf         encoded sensor data buffer
+ * @param[out] values      values to decode to
+ * @param[in]  max_count   maximum number of values to decode
+ * @param[out] errors      number of channels failed to decode
+ *
+ * @return Number of decoded values or negative error code.
+ */
+int wst_sensor_decode(
+	const wst_sensor_plan_t* plan,
+	uint32_t reads,
+	const uint8_t* buf,
+	wst_sensor_value_t* values,
+	uint16_t max_count,
+	uint32_t* errors);
+
+/**
+ * @brief Returns number of values wst_sensor_decode() yields for a buffer.
+ *
+ * @param[in]  plan        sensor decode plan
+ * @param[in]  buf         encoded sensor data buffer
+ *
+ * @return Number of frames of all channels in the buffer.
+ */
+uint16_t wst_sensor_decode_get_count(
+	const wst_sensor_plan_t* plan,
+	const uint8_t* buf);
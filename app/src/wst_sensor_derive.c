@@ -0,0 +1,302 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "wst_sensor_derive.h"
+#include "wst_sensor_types.h"
+#include "wst_sensor_utils.h"
+
+#include <zephyr/sys/util.h>
+
+#include <errno.h>
+#include <string.h>
+
+//
+// Derived values are in thousandths of the channel unit, published as q31
+// readings of a single shift covering every derived channel range
+//
+#define WST_DERIVE_SHIFT			(8)		// -256 .. 256 channel units
+
+//
+// Saturation vapour pressure over water in mPa, Magnus formula
+// 611.2 * exp(17.62 * t / (243.12 + t)), one entry per degree Celsius
+// from WST_DERIVE_ES_MIN. Linear interpolation is within 0.05 % of it.
+//
+#define WST_DERIVE_ES_MIN			(-50000)	// m°C of the first entry
+#define WST_DERIVE_ES_STEP			(1000)		// m°C between entries
+
+static const uint32_t saturation_pressure[] = {
+	6382, 7155, 8011, 8960, 10010, 11171, 12452, 13865,
+	15423, 17137, 19021, 21092, 23364, 25855, 28584, 31571,
+	34836, 38403, 42297, 46543, 51169, 56205, 61683, 67636,
+	74102, 81117, 88723, 96964, 105885, 115534, 125965, 137232,
+	149392, 162508, 176645, 191871, 208259, 225886, 244833, 265184,
+	287031, 310468, 335593, 362514, 391339, 422185, 455173, 490431,
+	528093, 568301, 611200, 656946, 705700, 757632, 812918, 871743,
+	934300, 1000793, 1071430, 1146433, 1226030, 1310462, 1399976, 1494834,
+	1595306, 1701672, 1814226, 1933273, 2059129, 2192122, 2332596, 2480904,
+	2637415, 2802511, 2976588, 3160057, 3353343, 3556889, 3771149, 3996598,
+	4233724, 4483033, 4745050, 5020314, 5309386, 5612842, 5931279, 6265314,
+	6615581, 6982737, 7367458, 7770442, 8192406, 8634094, 9096266, 9579710,
+	10085234, 10613672, 11165880, 11742740, 12345158, 12974067, 13630424, 14315214,
+	15029448, 15774163, 16550428, 17359335, 18202007, 19079598, 19993287,
+};
+
+#define WST_DERIVE_ES_MAX			\
+	(WST_DERIVE_ES_MIN + (int32_t) (ARRAY_SIZE(saturation_pressure) - 1) * WST_DERIVE_ES_STEP)
+
+#define WST_DERIVE_ZERO_CELSIUS		(273150)	// mK
+#define WST_DERIVE_HUMIDITY_FULL	(100000)	// m%RH of saturated air
+
+//
+// Derived channel kernels, temperatures in m°C, humidity in m%RH,
+// pressure in Pa (thousandths of kPa)
+//
+static int get_saturation_pressure(int32_t temp, int64_t* pressure_mpa)
+{
+	if ((temp < WST_DERIVE_ES_MIN) || (temp > WST_DERIVE_ES_MAX)) {
+		return -ERANGE;
+	}
+
+	uint32_t offset = (uint32_t) (temp - WST_DERIVE_ES_MIN);
+	uint32_t i = offset / WST_DERIVE_ES_STEP;
+	uint32_t fraction = offset % WST_DERIVE_ES_STEP;
+
+	*pressure_mpa = saturation_pressure[i];
+
+	if (fraction) {
+		*pressure_mpa +=
+			((int64_t) (saturation_pressure[i + 1] - saturation_pressure[i]) * fraction) /
+			WST_DERIVE_ES_STEP;
+	}
+	return 0;
+}
+
+static int get_vapour_pressure(int32_t temp, int32_t humidity, int64_t* pressure_mpa)
+{
+	int64_t saturation_mpa;
+
+	int rc = get_saturation_pressure(temp, &saturation_mpa);
+	if (rc != 0) {
+		return rc;
+	}
+
+	if (humidity <= 0) {
+		return -ERANGE;
+	}
+
+	*pressure_mpa = (saturation_mpa * MIN(humidity, WST_DERIVE_HUMIDITY_FULL)) /
+		WST_DERIVE_HUMIDITY_FULL;
+	return 0;
+}
+
+static int derive_dew_point(int32_t temp, int32_t humidity, int64_t* dew_point)
+{
+	int64_t vapour_mpa;
+
+	int rc = get_vapour_pressure(temp, humidity, &vapour_mpa);
+	if (rc != 0) {
+		return rc;
+	}
+
+	if (vapour_mpa < saturation_pressure[0]) {
+		return -ERANGE;
+	}
+
+	// Inverse lookup, dew point is the temperature saturating at the
+	// vapour pressure, table is increasing
+	size_t low = 0;
+	size_t high = ARRAY_SIZE(saturation_pressure) - 1;
+
+	while (high - low > 1) {
+		size_t middle = (low + high) / 2;
+
+		if (saturation_pressure[middle] <= vapour_mpa) {
+			low = middle;
+		} else {
+			high = middle;
+		}
+	}
+
+	*dew_point = WST_DERIVE_ES_MIN + (int64_t) low * WST_DERIVE_ES_STEP +
+		((vapour_mpa - saturation_pressure[low]) * WST_DERIVE_ES_STEP) /
+		(saturation_pressure[high] - saturation_pressure[low]);
+	*dew_point = MIN(*dew_point, temp);
+	return 0;
+}
+
+static int derive_abs_humidity(int32_t temp, int32_t humidity, int64_t* abs_humidity)
+{
+	int64_t vapour_mpa;
+
+	int rc = get_vapour_pressure(temp, humidity, &vapour_mpa);
+	if (rc != 0) {
+		return rc;
+	}
+
+	// Ideal gas law of water vapour, e / (Rv * T) with Rv = 461.5 J/(kg K),
+	// in mg/m3
+	*abs_humidity = (vapour_mpa * 2000000) / (923 * ((int64_t) temp + WST_DERIVE_ZERO_CELSIUS));
+	return 0;
+}
+
+static int64_t exp_q30(int64_t x)
+{
+	// Taylor series, converges within 1 ppm for |x| < 0.5 in 8 terms
+	int64_t term = BIT64(30);
+	int64_t sum = term;
+
+	for (int k = 1; k <= 8; k++) {
+		term = (term * x) / ((int64_t) BIT64(30) * k);
+		sum += term;
+	}
+	return sum;
+}
+
+static int derive_sea_level_pressure(int32_t press, int32_t temp, int32_t altitude_m, int64_t* sea_level)
+{
+	// Hypsometric equation over an air column in standard lapse rate of
+	// 6.5 K/km, p0 = p * exp(g * h / (Rd * Tm)), g / Rd = 34.1632 mK/m
+	int64_t column_mk = (int64_t) temp + WST_DERIVE_ZERO_CELSIUS + (3250LL * altitude_m) / 1000;
+
+	if ((press <= 0) || (column_mk <= 0)) {
+		return -ERANGE;
+	}
+
+	int64_t x = (34163LL * altitude_m * (int64_t) BIT64(30)) / (1000 * column_mk);
+
+	*sea_level = (press * exp_q30(x)) / (int64_t) BIT64(30);
+	return 0;
+}
+
+static int derive_heat_index(int32_t temp, int32_t humidity, int64_t* heat_index)
+{
+	// NWS heat index in hundredths of °F and %RH
+	int64_t t = ((int64_t) temp * 9) / 50 + 3200;
+	int64_t r = CLAMP(humidity, 0, WST_DERIVE_HUMIDITY_FULL) / 10;
+
+	// Steadman's simple formula, regression above 80 °F
+	int64_t index = (110 * t) / 100 - 1030 + (47 * r) / 1000;
+
+	if (index >= 8000) {
+		// Rothfusz regression, coefficients in 1e-8 °F grouped by
+		// powers of temperature
+		int64_t a = -4237900000LL + (1014333127LL * r) / 100 - (5481717LL * r * r) / 10000;
+		int64_t b = 204901523LL - (22475541LL * r) / 100 + (85282LL * r * r) / 10000;
+		int64_t c = -683783LL + (122874LL * r) / 100 - (199LL * r * r) / 10000;
+
+		index = (a + (b * t) / 100 + (c * t * t) / 10000) / 1000000;
+	}
+
+	*heat_index = ((index - 3200) * 50) / 9;
+	return 0;
+}
+
+static const wst_sensor_value_t* find_source(
+	const wst_sensor_plan_t* plan,
+	const wst_sensor_value_t* values,
+	uint16_t count,
+	uint16_t chan_type)
+{
+	uint16_t first = plan->channels[0].slot;
+
+	for (uint16_t i = 0; i < count; i++) {
+		const wst_sensor_value_t* value = &values[i];
+
+		if ((value->slot >= first) && (value->slot < first + plan->channel_count) &&
+			(value->spec.chan_type == chan_type)) {
+			return value;
+		}
+	}
+	return NULL;
+}
+
+static int32_t get_source_milli(const wst_sensor_value_t* value)
+{
+	int64_t milli = wst_q31_to_milli(
+		value->data.q31_data.readings[0].value,
+		value->data.q31_data.shift
+	);
+
+	return (int32_t) CLAMP(milli, INT32_MIN, INT32_MAX);
+}
+
+uint16_t wst_sensor_derive(
+	const wst_sensor_info_t* sensor,
+	const wst_sensor_plan_t* plan,
+	wst_sensor_value_t* values,
+	uint16_t count,
+	uint16_t max_count)
+{
+	if (!plan->derived_count || !plan->channel_count) {
+		return count;
+	}
+
+	const wst_sensor_value_t* temp = find_source(plan, values, count, SENSOR_CHAN_AMBIENT_TEMP);
+	const wst_sensor_value_t* humidity = find_source(plan, values, count, SENSOR_CHAN_HUMIDITY);
+	const wst_sensor_value_t* press = find_source(plan, values, count, SENSOR_CHAN_PRESS);
+	uint16_t derived = count;
+
+	if (!temp) {
+		// Every derived channel depends on temperature
+		return count;
+	}
+
+	for (uint16_t i = 0; (i < plan->derived_count) && (derived < max_count); i++) {
+		const wst_sensor_channel_plan_t* channel = &plan->derived[i];
+		int64_t milli;
+		int rc = -ENODATA;
+
+		switch (channel->spec.chan_type) {
+			case WST_CHANNEL_TYPE_DEW_POINT:
+				if (humidity) {
+					rc = derive_dew_point(get_source_milli(temp), get_source_milli(humidity), &milli);
+				}
+				break;
+			case WST_CHANNEL_TYPE_ABS_HUMIDITY:
+				if (humidity) {
+					rc = derive_abs_humidity(get_source_milli(temp), get_source_milli(humidity), &milli);
+				}
+				break;
+			case WST_CHANNEL_TYPE_HEAT_INDEX:
+				if (humidity) {
+					rc = derive_heat_index(get_source_milli(temp), get_source_milli(humidity), &milli);
+				}
+				break;
+			case WST_CHANNEL_TYPE_SEA_LEVEL_PRESS:
+				if (press) {
+					rc = derive_sea_level_pressure(
+						get_source_milli(press), get_source_milli(temp), sensor->altitude_m, &milli);
+				}
+				break;
+		}
+
+		if (rc != 0) {
+			continue;
+		}
+
+		wst_sensor_value_t* value = &values[derived++];
+
+		value->spec = channel->spec;
+		value->slot = channel->slot;
+		value->payload_type = channel->payload_type;
+		value->data.q31_data.header = temp->data.q31_data.header;
+		value->data.q31_data.header.reading_count = 1;
+		value->data.q31_data.shift = WST_DERIVE_SHIFT;
+		value->data.q31_data.readings[0].timestamp_delta = 0;
+		value->data.q31_data.readings[0].value = wst_milli_to_q31(milli, WST_DERIVE_SHIFT);
+	}
+
+	return derived;
+}
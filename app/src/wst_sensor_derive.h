@@ -0,0 +1,44 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include "wst_sensor_config.h"
+#include "wst_events.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Computes derived channels of a sensor from its decoded values.
+ *
+ * Derived values are appended after the values, stamped with the capture
+ * time of their first source channel. A derived channel is skipped when
+ * any of its source channels is missing from the values, or when its
+ * sources are out of the range of its kernel.
+ *
+ * @param[in]  sensor      sensor declaring derived channels
+ * @param[in]  plan        decode plan of the sensor
+ * @param[in,out] values   decoded values of a poll
+ * @param[in]  count       number of decoded values
+ * @param[in]  max_count   capacity of values
+ *
+ * @return Number of values including derived ones.
+ */
+uint16_t wst_sensor_derive(
+	const wst_sensor_info_t* sensor,
+	const wst_sensor_plan_t* plan,
+	wst_sensor_value_t* values,
+	uint16_t count,
+	uint16_t max_count);
@@ -0,0 +1,145 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "wst_sensor_filter.h"
+#include "wst_sensor_types.h"
+
+#include <zephyr/sys/util.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+void wst_sensor_filter_start(wst_sensor_filter_t* filter)
+{
+	filter->head = 0;
+	filter->count = 0;
+}
+
+static q31_t rescale_q31(q31_t q, int8_t from, int8_t to)
+{
+	if (from > to) {
+		int64_t value = (int64_t) q << MIN(from - to, 32);
+
+		return (q31_t) CLAMP(value, INT32_MIN, INT32_MAX);
+	}
+	return (q31_t) ((int64_t) q >> MIN(to - from, 63));
+}
+
+void wst_sensor_filter_push(wst_sensor_filter_t* filter, q31_t q, int8_t shift)
+{
+	if (!filter->count) {
+		filter->shift = shift;
+	} else if (shift != filter->shift) {
+		// Keep the burst on a single scale
+		q = rescale_q31(q, shift, filter->shift);
+	}
+
+	filter->samples[filter->head] = q;
+	filter->head = (filter->head + 1) % ARRAY_SIZE(filter->samples);
+	if (filter->count < ARRAY_SIZE(filter->samples)) {
+		filter->count++;
+	}
+}
+
+static void sort_q31(q31_t* values, uint8_t count)
+{
+	// Insertion sort, bursts are a few samples
+	for (uint8_t i = 1; i < count; i++) {
+		q31_t value = values[i];
+		int j = i - 1;
+
+		while ((j >= 0) && (values[j] > value)) {
+			values[j + 1] = values[j];
+			j--;
+		}
+		values[j + 1] = value;
+	}
+}
+
+static q31_t get_median(const q31_t* samples, uint8_t count)
+{
+	q31_t sorted[CONFIG_WST_SENSOR_BURST_MAX];
+
+	memcpy(sorted, samples, sizeof(q31_t) * count);
+	sort_q31(sorted, count);
+
+	if (count & 1) {
+		return sorted[count / 2];
+	}
+	return (q31_t) (((int64_t) sorted[count / 2 - 1] + sorted[count / 2]) / 2);
+}
+
+static void reject_outliers(q31_t* samples, uint8_t count)
+{
+	q31_t deviations[CONFIG_WST_SENSOR_BURST_MAX];
+	q31_t median = get_median(samples, count);
+
+	for (uint8_t i = 0; i < count; i++) {
+		deviations[i] = (q31_t) MIN(llabs((int64_t) samples[i] - median), INT32_MAX);
+	}
+
+	// Hampel identifier, 1.4826 * MAD estimates the standard deviation
+	// of normally distributed samples, 1.4826 ~ 1518 / 1024
+	int64_t mad = get_median(deviations, count);
+	int64_t threshold = (CONFIG_WST_SENSOR_FILTER_HAMPEL_K * mad * 1518) / 1024;
+
+	for (uint8_t i = 0; i < count; i++) {
+		if (deviations[i] > threshold) {
+			samples[i] = median;
+		}
+	}
+}
+
+bool wst_sensor_filter_get(wst_sensor_filter_t* filter, uint8_t stages, q31_t* q, int8_t* shift)
+{
+	q31_t samples[CONFIG_WST_SENSOR_BURST_MAX];
+	uint8_t count = filter->count;
+	int64_t value;
+
+	if (!count) {
+		return false;
+	}
+
+	memcpy(samples, filter->samples, sizeof(q31_t) * count);
+
+	if ((stages & WST_FILTER_HAMPEL) && (count > 2)) {
+		reject_outliers(samples, count);
+	}
+
+	if (stages & WST_FILTER_MEDIAN) {
+		value = get_median(samples, count);
+	} else {
+		value = 0;
+		for (uint8_t i = 0; i < count; i++) {
+			value += samples[i];
+		}
+		value /= count;
+	}
+
+	if (stages & WST_FILTER_EMA) {
+		if (filter->ema_valid && (filter->ema_shift == filter->shift)) {
+			filter->ema += (value - filter->ema) / (int64_t) BIT(CONFIG_WST_SENSOR_FILTER_EMA_SHIFT);
+		} else {
+			filter->ema = value;
+			filter->ema_shift = filter->shift;
+			filter->ema_valid = true;
+		}
+		value = filter->ema;
+	}
+
+	*q = (q31_t) value;
+	*shift = filter->shift;
+	return true;
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <zephyr/dsp/types.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//
+// Filter of a channel sampled in bursts, burst samples are kept in
+// a fixed size ring buffer and reduced to a single value
+//
+typedef struct wst_sensor_filter {
+	q31_t samples[CONFIG_WST_SENSOR_BURST_MAX];
+	uint8_t head;			// next sample index
+	uint8_t count;			// number of samples in the burst
+	int8_t shift;			// shift of the samples
+	int8_t ema_shift;		// shift of the moving average
+	bool ema_valid;
+	int64_t ema;			// moving average across bursts
+} wst_sensor_filter_t;
+
+/**
+ * @brief Starts new burst, moving average is kept.
+ *
+ * @param[in,out] filter   channel filter
+ */
+void wst_sensor_filter_start(wst_sensor_filter_t* filter);
+
+/**
+ * @brief Adds burst sample.
+ *
+ * Samples beyond CONFIG_WST_SENSOR_BURST_MAX overwrite the oldest ones.
+ *
+ * @param[in,out] filter   channel filter
+ * @param[in]  q           q31 sample
+ * @param[in]  shift       shift of the sample
+ */
+void wst_sensor_filter_push(wst_sensor_filter_t* filter, q31_t q, int8_t shift);
+
+/**
+ * @brief Reduces burst samples to a single value.
+ *
+ * Stages are applied in order: Hampel outlier rejection, median or mean
+ * of the burst, exponential moving average across bursts.
+ *
+ * @param[in,out] filter   channel filter
+ * @param[in]  stages      WST_FILTER_* stages, mean of the burst if 0
+ * @param[out] q           filtered q31 value
+ * @param[out] shift       shift of the filtered value
+ *
+ * @return false if the burst has no samples.
+ */
+bool wst_sensor_filter_get(wst_sensor_filter_t* filter, uint8_t stages, q31_t* q, int8_t* shift);
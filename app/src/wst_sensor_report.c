@@ -0,0 +1,74 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "wst_sensor_report.h"
+
+#include <zephyr/sys/util.h>
+
+#include <errno.h>
+#include <string.h>
+
+void wst_sensor_report_init(wst_sensor_report_t* report)
+{
+	memset(report, 0, sizeof(*report));
+}
+
+int wst_sensor_report_set_deadband(wst_sensor_report_t* report, uint16_t slot, int32_t deadband)
+{
+	if ((slot >= WST_SENSOR_CHANNEL_COUNT) || (deadband < 0)) {
+		return -EINVAL;
+	}
+
+	report->deadband[slot] = deadband;
+	return 0;
+}
+
+bool wst_sensor_report_is_due(const wst_sensor_report_t* report, uint16_t slot, int64_t value, int64_t now_ms)
+{
+	if ((slot >= WST_SENSOR_CHANNEL_COUNT) ||
+		!report->delivered[slot] ||
+		!report->deadband[slot]) {
+		return true;
+	}
+
+	if ((CONFIG_WST_REPORT_HEARTBEAT_MS > 0) &&
+		(now_ms - report->time_ms[slot] >= CONFIG_WST_REPORT_HEARTBEAT_MS)) {
+		return true;
+	}
+
+	int64_t change = value - report->value[slot];
+
+	return ABS(change) >= report->deadband[slot];
+}
+
+void wst_sensor_report_sent(wst_sensor_report_t* report, uint16_t slot, int64_t value)
+{
+	if (slot < WST_SENSOR_CHANNEL_COUNT) {
+		report->pending[slot] = value;
+		report->sent[slot] = true;
+	}
+}
+
+void wst_sensor_report_completed(wst_sensor_report_t* report, bool delivered, int64_t now_ms)
+{
+	for (uint16_t i = 0; i < WST_SENSOR_CHANNEL_COUNT; i++) {
+		if (report->sent[i] && delivered) {
+			report->value[i] = report->pending[i];
+			report->time_ms[i] = now_ms;
+			report->delivered[i] = true;
+		}
+		report->sent[i] = false;
+	}
+}
@@ -0,0 +1,88 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include "wst_sensor_config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//
+// Report-on-change state of each channel slot, values are in thousandths
+// of the channel unit
+//
+typedef struct wst_sensor_report {
+	int32_t deadband[WST_SENSOR_CHANNEL_COUNT];		// 0 sends the channel on every uplink
+	int64_t value[WST_SENSOR_CHANNEL_COUNT];		// last delivered value
+	int64_t time_ms[WST_SENSOR_CHANNEL_COUNT];		// uptime of the last delivery
+	int64_t pending[WST_SENSOR_CHANNEL_COUNT];		// value sent in the uplink in flight
+	bool delivered[WST_SENSOR_CHANNEL_COUNT];
+	bool sent[WST_SENSOR_CHANNEL_COUNT];
+} wst_sensor_report_t;
+
+/**
+ * @brief Initializes report state, no channel is delivered yet.
+ *
+ * @param[out] report      report state to initialize
+ */
+void wst_sensor_report_init(wst_sensor_report_t* report);
+
+/**
+ * @brief Sets report-on-change threshold of a channel.
+ *
+ * @param[in,out] report   report state
+ * @param[in]  slot        index of the channel among all configured channels
+ * @param[in]  deadband    threshold in thousandths of the channel unit,
+ *                         0 sends the channel on every uplink
+ *
+ * @return 0 on success, -EINVAL for unknown slot or negative threshold.
+ */
+int wst_sensor_report_set_deadband(wst_sensor_report_t* report, uint16_t slot, int32_t deadband);
+
+/**
+ * @brief Checks if a channel value is to be sent.
+ *
+ * Value is sent if the channel was never delivered, moved by at least its
+ * threshold since it was last delivered, or was silent for
+ * CONFIG_WST_REPORT_HEARTBEAT_MS.
+ *
+ * @param[in]  report      report state
+ * @param[in]  slot        index of the channel among all configured channels
+ * @param[in]  value       channel value
+ * @param[in]  now_ms      current uptime
+ */
+bool wst_sensor_report_is_due(const wst_sensor_report_t* report, uint16_t slot, int64_t value, int64_t now_ms);
+
+/**
+ * @brief Records channel value sent in the uplink in flight.
+ *
+ * @param[in,out] report   report state
+ * @param[in]  slot        index of the channel among all configured channels
+ * @param[in]  value       channel value
+ */
+void wst_sensor_report_sent(wst_sensor_report_t* report, uint16_t slot, int64_t value);
+
+/**
+ * @brief Completes the uplink in flight.
+ *
+ * Values sent become the delivered ones on success, and are sent again
+ * on the next uplink otherwise.
+ *
+ * @param[in,out] report   report state
+ * @param[in]  delivered   true if the uplink was delivered
+ * @param[in]  now_ms      current uptime
+ */
+void wst_sensor_report_completed(wst_sensor_report_t* report, bool delivered, int64_t now_ms);
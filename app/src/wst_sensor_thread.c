@@ -16,140 +16,655 @@
 #include "wst_sensor_thread.h"
 #include "wst_sensor_config.h"
 #include "wst_sensor_utils.h"
+#include "wst_sensor_decode.h"
+#include "wst_sensor_client.h"
+#include "wst_sensor_filter.h"
+#include "wst_sensor_derive.h"
 #include "wst_events.h"
+#include "wst_clock.h"
 
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/device.h>
-#include <zephyr/sys/slist.h>
 #include <zephyr/sys/__assert.h>
 #include <zephyr/devicetree.h>
 #include <zephyr/drivers/sensor.h>
 #include <zephyr/drivers/sensor_data_types.h>
+#include <zephyr/drivers/i2c.h>
 #include <zephyr/rtio/rtio.h>
-#include <zephyr/dsp/print_format.h>
+#include <zephyr/sys/atomic.h>
+
+#include <string.h>
 
 
 #define LOG_LEVEL CONFIG_LOG_DEFAULT_LEVEL
 //#define LOG_LEVEL LOG_LEVEL_DBG
 LOG_MODULE_REGISTER(wst_sensor_thread);
 
-#define WST_SENSOR_RTIO_SQE_NUM		(8)		// Number of the sensing RTIO SQE
-#define WST_SENSOR_RTIO_CQE_NUM		(8)		// Number of the sensing RTIO SQE
-#define WST_SENSOR_RTIO_BLOCK_SIZE	(64)	// Block size of the RTIO context
-#define WST_SENSOR_RTIO_BLOCK_COUNT	(8)		// Number of memory blocks of the RTIO context
+//
+// RTIO context of each acquisition group is sized from its sensors: two read
+// requests and completions per sensor, one in flight and one dropped after
+// a stall, and enough memory blocks to hold the encoded buffers of all its
+// sensors polled on the same deadline.
+//
+#define WST_SENSOR_RTIO_SQE_NUM(group)		MAX(2 * WST_SENSOR_GROUP_SENSOR_COUNT(group), 1)
+#define WST_SENSOR_RTIO_CQE_NUM(group)		MAX(2 * WST_SENSOR_GROUP_SENSOR_COUNT(group), 1)
+#define WST_SENSOR_RTIO_BLOCK_SIZE			(32)	// Block size of the RTIO context, power of two
+#define WST_SENSOR_RTIO_BLOCK_COUNT(group)	\
+	MAX(WST_SENSOR_GROUP_BLOCK_COUNT(group, WST_SENSOR_RTIO_BLOCK_SIZE), 1)
 
-RTIO_DEFINE_WITH_MEMPOOL(
-	rtio_ctx,
-	WST_SENSOR_RTIO_SQE_NUM,
-	WST_SENSOR_RTIO_CQE_NUM,
-	WST_SENSOR_RTIO_BLOCK_COUNT,
-	WST_SENSOR_RTIO_BLOCK_SIZE,
-	sizeof(void *)
-);
+#define WST_SENSOR_GROUP_COUNT		CONFIG_WST_SENSOR_GROUP_COUNT
+
+#define WST_SENSOR_STREAM_BLOCK_SIZE	(64)	// Block size of the streaming RTIO context
+#define WST_SENSOR_STREAM_BLOCK_COUNT	(32)	// Number of memory blocks of the streaming RTIO context
+#define WST_SENSOR_STREAM_RETRY_MS		(1000)	// Failed streams are restarted after N ms times their backoff
+
+#define WST_SENSOR_BACKOFF_MAX_SHIFT	(4)		// Failing sensors are retried at most every 2^N periods
+#define WST_SENSOR_PROBE_MAX_SHIFT		(6)		// Offline sensors are re-probed at most every 2^N periods
+#define WST_SENSOR_READ_TOKENS			(4)		// Reads of a sensor told apart in flight
+
+BUILD_ASSERT(WST_SENSOR_COUNT <= 32, "Sensor due mask is limited to 32 sensors");
+BUILD_ASSERT(IS_POWER_OF_TWO(WST_SENSOR_RTIO_BLOCK_SIZE), "RTIO block size must be a power of two");
+BUILD_ASSERT(IS_ENABLED(CONFIG_RTIO_CONSUME_SEM), "Bounded reads wait on the RTIO consume semaphore");
+
+#define WST_SENSOR_RTIO_DEFINE(_group, _)										\
+	RTIO_DEFINE_WITH_MEMPOOL(													\
+		_CONCAT(rtio_ctx, _group),												\
+		WST_SENSOR_RTIO_SQE_NUM(_group),										\
+		WST_SENSOR_RTIO_CQE_NUM(_group),										\
+		WST_SENSOR_RTIO_BLOCK_COUNT(_group),									\
+		WST_SENSOR_RTIO_BLOCK_SIZE,												\
+		sizeof(void *)															\
+	)
+
+LISTIFY(WST_SENSOR_GROUP_COUNT, WST_SENSOR_RTIO_DEFINE, (;));
+
+#define WST_SENSOR_RTIO_REFERENCE(_group, _)									\
+	&_CONCAT(rtio_ctx, _group)
+
+#define WST_SENSOR_RTIO_BLOCK_COUNT_REFERENCE(_group, _)						\
+	WST_SENSOR_RTIO_BLOCK_COUNT(_group)
+
+//
+// Acquisition group, sensors of different groups are acquired in parallel
+// and decoded into their own region of the shared sensor message.
+//
+typedef struct wst_sensor_group {
+	struct rtio* ctx;
+	uint32_t block_count;		// memory blocks of the RTIO context
+	uint16_t sensor_count;		// number of sensors in the group
+	uint16_t first;				// first message value reserved for the group
+	uint16_t max_count;			// number of message values reserved for the group
+	uint16_t prepared;			// number of reads queued for the next poll
+	struct rtio_sqe* last;		// last read queued for the next poll
+	uint16_t conversion_ms;		// longest conversion time of reads queued for the next poll
+	uint16_t count;				// number of values decoded by the last poll
+	wst_sensor_value_t* values;	// message values of the current poll
+	struct k_sem start;			// starts acquisition of a worker group
+	struct k_sem done;			// signaled by a worker group on acquisition completion
+	struct k_mutex lock;		// guards message values against an abandoned poll
+	atomic_t cancelled;			// poll abandoned by SENSOR thread, set under lock
+	bool stuck;					// worker still busy with an abandoned poll
+	uint32_t buf_len_hwm;		// largest encoded buffer
+	uint32_t blocks_hwm;		// most blocks used by a single poll
+} wst_sensor_group_t;
+
+static struct rtio* const group_rtio_ctxs[] = {
+	LISTIFY(WST_SENSOR_GROUP_COUNT, WST_SENSOR_RTIO_REFERENCE, (,))
+};
+
+static const uint32_t group_block_counts[] = {
+	LISTIFY(WST_SENSOR_GROUP_COUNT, WST_SENSOR_RTIO_BLOCK_COUNT_REFERENCE, (,))
+};
+
+static wst_sensor_group_t sensor_groups[WST_SENSOR_GROUP_COUNT];
 
-typedef struct wst_sensor_node_data {
-	sys_snode_t node;
-	struct sensor_chan_spec spec;
-	wst_sensor_data_t data;
-} wst_sensor_node_data_t;
+#if (WST_SENSOR_GROUP_COUNT > 1)
+//
+// Worker threads of groups other than 0, group 0 is acquired by SENSOR thread
+//
+K_THREAD_STACK_ARRAY_DEFINE(wst_sensor_group_stacks, WST_SENSOR_GROUP_COUNT - 1, WST_SENSOR_GROUP_STACKSIZE);
+static struct k_thread wst_sensor_group_threads[WST_SENSOR_GROUP_COUNT - 1];
+#endif
 
+//
+// Size of a sensor message able to carry every configured channel
+//
+#define WST_SENSOR_MSG_SIZE	\
+	(sizeof(wst_event_msg_t) + sizeof(wst_sensor_value_t) * WST_SENSOR_CHANNEL_COUNT)
 
-static wst_sensor_node_data_t* add_sensor_data_node(
-	sys_slist_t* list,
-	struct sensor_chan_spec spec,
-	wst_sensor_data_t* data)
+//
+// Absolute deadline acquisition schedule
+//
+typedef struct wst_sensor_schedule {
+	int64_t deadline;		// next acquisition deadline, ms of uptime
+	uint32_t period_ms;		// acquisition period
+	uint32_t overruns;		// number of skipped acquisition periods
+} wst_sensor_schedule_t;
+
+static void schedule_align(wst_sensor_schedule_t* schedule)
+{
+#if defined(CONFIG_WST_SENSOR_ALIGN_TO_NETWORK_TIME)
+	int64_t offset_ms;
+
+	if (wst_clock_get_network_offset(&offset_ms) == 0) {
+		// Move deadline forward to the next period boundary in network time
+		int64_t phase = (schedule->deadline + offset_ms) % schedule->period_ms;
+
+		if (phase) {
+			schedule->deadline += schedule->period_ms - phase;
+		}
+	}
+#else
+	ARG_UNUSED(schedule);
+#endif
+}
+
+static void schedule_init(wst_sensor_schedule_t* schedule, uint32_t period_ms, int64_t start)
 {
-	wst_sensor_node_data_t* sensor_data = malloc(sizeof(wst_sensor_node_data_t));
-	sensor_data->node.next = NULL;
-	sensor_data->spec = spec;
-	sensor_data->data = *data;
+	schedule->deadline = start;
+	schedule->period_ms = period_ms;
+	schedule->overruns = 0;
 
-	sys_slist_append(list, &sensor_data->node);
-	return sensor_data;
+	schedule_align(schedule);
 }
 
-static void free_sensor_data_node(wst_sensor_node_data_t* node)
+static void schedule_advance(wst_sensor_schedule_t* schedule, uint32_t periods)
 {
-	free(node);
+	int64_t now = k_uptime_get();
+
+	schedule->deadline += (int64_t) periods * schedule->period_ms;
+
+	if (now >= schedule->deadline) {
+		// Acquisition took longer than a period, skip missed deadlines
+		// but keep the original phase.
+		uint32_t missed = (uint32_t) ((now - schedule->deadline) / schedule->period_ms) + 1;
+
+		schedule->deadline += (int64_t) missed * schedule->period_ms;
+		schedule->overruns += missed;
+
+		LOG_WRN("Acquisition overrun, %u period(s) skipped, %u total",
+			missed,
+			schedule->overruns
+		);
+	}
+
+	schedule_align(schedule);
 }
 
+//
+// Sensor health, failing sensors are retried and offline sensors
+// are re-probed with exponential backoff
+//
+typedef enum wst_sensor_health {
+	wst_sensor_health_ok,
+	wst_sensor_health_degraded,		// device ready, reads failing
+	wst_sensor_health_offline,		// device not ready
+} wst_sensor_health_t;
 
-static int decode_sensor_data(
-	sys_slist_t* values,
-	const struct sensor_read_config* sensor_config,
-	uint8_t *buf
-)
+//
+// Identifies a read request in its completion, a completion whose read is
+// not the last one queued for the sensor belongs to a dropped read
+//
+typedef struct wst_sensor_read {
+	struct wst_sensor_state* state;
+} wst_sensor_read_t;
+
+//
+// Runtime state of each configured sensor
+//
+typedef struct wst_sensor_state {
+	const wst_sensor_info_t* info;
+	struct rtio_iodev* iodev;
+	struct rtio_iodev* stream_iodev;
+	bool streaming;			// acquired by FIFO streaming instead of polling
+	const wst_sensor_plan_t* plan;
+	wst_sensor_group_t* group;
+	wst_sensor_schedule_t schedule;
+	wst_sensor_health_t health;
+	uint32_t failures;		// number of consecutive failed reads
+	uint32_t reads;			// number of completed reads, drives channel decimation
+	wst_sensor_read_t read_tokens[WST_SENSOR_READ_TOKENS];
+	uint8_t token;			// token of the last read queued
+	bool pending;			// read request in flight, not completed yet
+	bool timed_out;			// read request in flight has timed out
+	int64_t stalled_at;		// time of the read timeout, ms of uptime
+#if defined(CONFIG_WST_SENSOR_TRIGGER)
+	struct sensor_trigger trigger;
+#endif
+#if defined(CONFIG_WST_SENSOR_STREAM)
+	int64_t stream_restart_at;	// restart time of a failed stream, INT64_MAX if running
+#endif
+} wst_sensor_state_t;
+
+static wst_sensor_state_t sensor_states[WST_SENSOR_COUNT];
+
+//
+// Acquisition failure counters, by failure class, shared by all groups
+//
+static struct {
+	atomic_t submit;		// no free submission queue entry
+	atomic_t read;			// read completed with error
+	atomic_t buffer;		// no mempool buffer attached to completion
+	atomic_t decode;		// channel decoding failed
+	atomic_t timeout;		// read not completed in time
+} failure_stats;
+
+//
+// Acquisition stall statistics, stall is the time from a read timeout
+// to its late completion, or to the abandon of a stuck group poll
+//
+static struct {
+	atomic_t stalls;		// number of read timeouts and stuck groups
+	atomic_t recoveries;	// number of stalled reads completed late
+	atomic_t stall_ms;		// total stall time
+	atomic_t max_stall_ms;	// longest stall time
+} stall_stats;
+
+static void sensor_failed(wst_sensor_state_t* state, int rc)
 {
-	const struct sensor_decoder_api *decoder;
-	wst_sensor_data_t data;
-	uint16_t count = 0;
+	state->failures++;
+
+	if (state->health != wst_sensor_health_degraded) {
+		LOG_WRN("%s degraded (%d)", state->info->name, rc);
+		state->health = wst_sensor_health_degraded;
+	}
+
+	LOG_DBG("failures: submit %ld, read %ld, buffer %ld, decode %ld, timeout %ld",
+		atomic_get(&failure_stats.submit),
+		atomic_get(&failure_stats.read),
+		atomic_get(&failure_stats.buffer),
+		atomic_get(&failure_stats.decode),
+		atomic_get(&failure_stats.timeout)
+	);
+}
+
+static void sensor_succeeded(wst_sensor_state_t* state)
+{
+	if (state->health != wst_sensor_health_ok) {
+		LOG_INF("%s recovered after %u failure(s)", state->info->name, state->failures);
+		state->health = wst_sensor_health_ok;
+	}
+	state->failures = 0;
+}
+
+static uint32_t get_backoff_periods(const wst_sensor_state_t* state)
+{
+	if (state->failures == 0) {
+		return 1;
+	}
+
+	if (state->health == wst_sensor_health_offline) {
+		return BIT(MIN(state->failures, WST_SENSOR_PROBE_MAX_SHIFT));
+	}
+	return BIT(MIN(state->failures, WST_SENSOR_BACKOFF_MAX_SHIFT));
+}
+
+//
+// Wakes up SENSOR thread before the deadline, on sensor triggers,
+// on changes of the client intervals, and when streaming stops
+//
+static K_SEM_DEFINE(wakeup_sem, 0, 1);
+
+#if defined(CONFIG_WST_SENSOR_TRIGGER)
+
+//
+// Sensors whose trigger fired since they were last read
+//
+static atomic_t trigger_pending;
+
+static void trigger_handler(const struct device* dev, const struct sensor_trigger* trigger)
+{
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		if ((sensor_states[i].info->sensor_device == dev) &&
+			(sensor_states[i].trigger.type == trigger->type)) {
+			atomic_set_bit(&trigger_pending, i);
+		}
+	}
+
+	// Wake up SENSOR thread
+	k_sem_give(&wakeup_sem);
+}
 
-	int rc = sensor_get_decoder(sensor_config->sensor, &decoder);
+static void set_sensor_trigger(wst_sensor_state_t* state)
+{
+	state->trigger.type = state->info->trigger_type;
+	state->trigger.chan = state->info->trigger_channel;
+
+	int rc = sensor_trigger_set(state->info->sensor_device, &state->trigger, trigger_handler);
 	if (rc != 0) {
-		LOG_ERR("sensor_get_decoder failed %d", rc);
-		return rc;
+		LOG_WRN("%s trigger %d not set %d, polling only", state->info->name, state->trigger.type, rc);
+	} else {
+		LOG_INF("%s acquired on trigger %d", state->info->name, state->trigger.type);
 	}
+}
 
-	for (size_t i = 0; i < sensor_config->count; i++) {
+#endif
 
-		// Frame iterators, one per channel we are decoding
-		uint32_t fits = 0;
+static bool probe_sensor(wst_sensor_state_t* state)
+{
+	if (state->health != wst_sensor_health_offline) {
+		return true;
+	}
 
-		// Try to decode
-		rc = decoder->decode(
-			buf,
-			sensor_config->channels[i],
-			&fits,
-			1,
-			&data
-		);
+	if (!device_is_ready(state->info->sensor_device)) {
+		state->failures++;
+		LOG_DBG("%s still offline, %u probe(s)", state->info->name, state->failures);
+		return false;
+	}
 
-		if (rc < 0) {
-			// In case of failure, fail gracefully,
-			// and try next channel, if any.
-			LOG_WRN("sensor decoding failed %d", rc);
-		} else {
-			// Add sensor channel data
-			switch (wst_sensor_get_channel_format(sensor_config->channels[i].chan_type)) {
-
-				case wst_sensor_format_scalar:
-					LOG_DBG("%s for %s channel 0, result - %d, value - %" PRIsensor_q31_data,
-						wst_sensor_get_channel_name(sensor_config->channels[i].chan_type),
-						sensor_config->sensor->name,
-						rc,
-						PRIsensor_q31_data_arg(data.q31_data, 0)
-					);
-					break;
-
-				case wst_sensor_format_3d_vector:
-					LOG_DBG("%s for %s channel 0, result - %d, value - %" PRIsensor_three_axis_data,
-						wst_sensor_get_channel_name(sensor_config->channels[i].chan_type),
-						sensor_config->sensor->name,
-						rc,
-						PRIsensor_three_axis_data_arg(data.q31_3d_data, 0)
-					);
-					break;
-
-				case wst_sensor_format_occurence:
-				case wst_sensor_format_byte_data:
-				case wst_sensor_format_uint64_data:
-				default:
-					break;
-			};
-
-			add_sensor_data_node(
-				values,
-				sensor_config->channels[i],
-				&data);
+	LOG_INF("%s online after %u probe(s)", state->info->name, state->failures);
+	wst_sensor_set_attributes(state->info);
+
+#if defined(CONFIG_WST_SENSOR_TRIGGER)
+	// Trigger was never set on a sensor offline at start
+	if ((state->info->trigger_type != WST_SENSOR_TRIGGER_NONE) && !state->streaming) {
+		set_sensor_trigger(state);
+	}
+#endif
+
+	state->health = wst_sensor_health_ok;
+	state->failures = 0;
+	return true;
+}
+
+static void record_stall(const char* name, int64_t stalled_at)
+{
+	uint32_t stall_ms = (uint32_t) (k_uptime_get() - stalled_at);
 
-			count++;
+	atomic_add(&stall_stats.stall_ms, stall_ms);
+
+	atomic_val_t max_ms = atomic_get(&stall_stats.max_stall_ms);
+	while ((stall_ms > (uint32_t) max_ms) &&
+		!atomic_cas(&stall_stats.max_stall_ms, max_ms, stall_ms)) {
+		max_ms = atomic_get(&stall_stats.max_stall_ms);
+	}
+
+	LOG_WRN("%s stalled for %u ms, stalls %ld, recoveries %ld, total %ld ms, max %ld ms",
+		name,
+		stall_ms,
+		atomic_get(&stall_stats.stalls),
+		atomic_get(&stall_stats.recoveries),
+		atomic_get(&stall_stats.stall_ms),
+		atomic_get(&stall_stats.max_stall_ms)
+	);
+}
+
+static void recover_sensor_bus(const wst_sensor_state_t* state)
+{
+#if defined(CONFIG_I2C)
+	const struct device* bus = state->info->i2c_bus;
+
+	if (!bus) {
+		return;
+	}
+
+	// Release a bus held low by a hung sensor
+	int64_t start = k_uptime_get();
+	int rc = i2c_recover_bus(bus);
+
+	LOG_WRN("%s bus %s recovery %d in %u ms",
+		state->info->name,
+		bus->name,
+		rc,
+		(uint32_t) (k_uptime_get() - start)
+	);
+#else
+	ARG_UNUSED(state);
+#endif
+}
+
+static void expire_sensor_reads(wst_sensor_group_t* group)
+{
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		wst_sensor_state_t* state = &sensor_states[i];
+
+		if ((state->group != group) || !state->pending || state->timed_out) {
+			continue;
 		}
+
+		LOG_ERR("%s read timed out", state->info->name);
+
+		// A submitted read is not canceled, it may complete and free its
+		// request concurrently. Its completion is discarded when it arrives.
+		state->timed_out = true;
+		state->stalled_at = k_uptime_get();
+		atomic_inc(&failure_stats.timeout);
+		atomic_inc(&stall_stats.stalls);
+		sensor_failed(state, -ETIMEDOUT);
+
+		recover_sensor_bus(state);
 	}
-	return (int) count;
 }
 
-static uint16_t wst_sensor_get_data(const wst_sensor_config_t* config, sys_slist_t* values)
+static void queue_sensor_read(wst_sensor_state_t* state)
+{
+	wst_sensor_group_t* group = state->group;
+	struct rtio_sqe *sqe = rtio_sqe_acquire(group->ctx);
+
+	if (!sqe) {
+		LOG_ERR("no free RTIO submission for %s", state->info->name);
+		atomic_inc(&failure_stats.submit);
+		sensor_failed(state, -ENOMEM);
+		return;
+	}
+
+	state->token = (state->token + 1) % WST_SENSOR_READ_TOKENS;
+
+	rtio_sqe_prep_read_with_pool(sqe, state->iodev, RTIO_PRIO_NORM, &state->read_tokens[state->token]);
+	state->pending = true;
+
+#if defined(CONFIG_WST_SENSOR_CHAIN)
+	// Link to the previous read of the group, so that the group's reads
+	// are executed back to back as a single transaction
+	if (group->last) {
+		group->last->flags |= RTIO_SQE_CHAINED;
+	}
+	group->last = sqe;
+#endif
+
+	group->conversion_ms = MAX(group->conversion_ms, state->info->conversion_time_ms);
+	group->prepared++;
+}
+
+//
+// Discards completion of a timed out or dropped read, its data is stale
+//
+static bool discard_late_read(
+	wst_sensor_group_t* group,
+	const wst_sensor_read_t* read,
+	uint8_t* buf,
+	uint32_t buf_len)
+{
+	wst_sensor_state_t* state = read->state;
+
+	if (read != &state->read_tokens[state->token]) {
+		// Read was dropped after a stall
+		LOG_WRN("%s dropped read completed", state->info->name);
+	} else if (state->timed_out) {
+		atomic_inc(&stall_stats.recoveries);
+		record_stall(state->info->name, state->stalled_at);
+
+		state->timed_out = false;
+		state->pending = false;
+	} else {
+		return false;
+	}
+
+	if (buf) {
+		rtio_release_buffer(group->ctx, buf, buf_len);
+	}
+	return true;
+}
+
+//
+// Consumes completions of timed out reads arrived since the last poll,
+// whether or not the group has reads of its own, and drops reads stalled
+// for too long so that their sensors are read again
+//
+static void drain_sensor_reads(wst_sensor_group_t* group)
+{
+	struct rtio_cqe* cqe;
+
+	while ((cqe = rtio_cqe_consume(group->ctx)) != NULL) {
+		uint8_t *buf;
+		uint32_t buf_len;
+
+		const wst_sensor_read_t* read = (const wst_sensor_read_t*) cqe->userdata;
+
+		if (rtio_cqe_get_mempool_buffer(group->ctx, cqe, &buf, &buf_len) != 0) {
+			buf = NULL;
+		}
+
+		rtio_cqe_release(group->ctx, cqe);
+
+		if (!discard_late_read(group, read, buf, buf_len) && buf) {
+			// No read of the group is in flight between polls
+			rtio_release_buffer(group->ctx, buf, buf_len);
+		}
+	}
+
+	int64_t now = k_uptime_get();
+
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		wst_sensor_state_t* state = &sensor_states[i];
+
+		if ((state->group == group) && state->timed_out &&
+			(now - state->stalled_at >= CONFIG_WST_SENSOR_STALL_TIMEOUT_MS)) {
+			LOG_ERR("%s read dropped after %u ms", state->info->name, (uint32_t) (now - state->stalled_at));
+			record_stall(state->info->name, state->stalled_at);
+
+			// Completion of the dropped read is told apart from the next read
+			state->token = (state->token + 1) % WST_SENSOR_READ_TOKENS;
+			state->timed_out = false;
+			state->pending = false;
+		}
+	}
+}
+
+//
+// Returns true while the worker of a group is busy with an abandoned poll,
+// its sensors are not read until then
+//
+static bool is_group_stuck(wst_sensor_group_t* group)
+{
+	if (group->stuck && (k_sem_take(&group->done, K_NO_WAIT) == 0)) {
+		LOG_INF("group %u resumed", (unsigned int) (group - sensor_groups));
+		group->stuck = false;
+	}
+	return group->stuck;
+}
+
+static void prepare_sensor_reads(uint32_t due)
+{
+	uint32_t ready = 0;
+
+	for (int i = 0; i < WST_SENSOR_GROUP_COUNT; i++) {
+		sensor_groups[i].prepared = 0;
+		sensor_groups[i].last = NULL;
+		sensor_groups[i].conversion_ms = 0;
+
+		if (!is_group_stuck(&sensor_groups[i])) {
+			drain_sensor_reads(&sensor_groups[i]);
+		}
+	}
+
+	// Offline sensors are not read until they are ready again, and
+	// sensors with a timed out read until it completes
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		if ((due & BIT(i)) && !sensor_states[i].group->stuck &&
+			!sensor_states[i].pending && probe_sensor(&sensor_states[i])) {
+			ready |= BIT(i);
+		}
+	}
+
+	// Queue read requests for each sensor due on its group's context,
+	// without submitting them. Healthy sensors go first, a failed read
+	// cancels the rest of a chain.
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		if ((ready & BIT(i)) && (sensor_states[i].health == wst_sensor_health_ok)) {
+			queue_sensor_read(&sensor_states[i]);
+		}
+	}
+
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		if ((ready & BIT(i)) && (sensor_states[i].health != wst_sensor_health_ok)) {
+			queue_sensor_read(&sensor_states[i]);
+		}
+	}
+}
+
+//
+// Stamps sensor message with the capture time of its earliest value, taken
+// from the decoded data headers, and each value with its offset to it.
+// Sensor timestamps are in ns of uptime, mapped to network time once the
+// clock is synchronized.
+//
+static void stamp_sensor_data(wst_event_msg_t* msg)
+{
+	uint64_t base_ns = UINT64_MAX;
+	int64_t offset_ms;
+
+	for (uint16_t i = 0; i < msg->sensor.count; i++) {
+		// Data header is first in every decoded data format
+		base_ns = MIN(base_ns, msg->sensor.values[i].data.q31_data.header.base_timestamp_ns);
+	}
+
+	for (uint16_t i = 0; i < msg->sensor.count; i++) {
+		wst_sensor_value_t* value = &msg->sensor.values[i];
+
+		value->time_delta_ms = (uint32_t)
+			((value->data.q31_data.header.base_timestamp_ns - base_ns) / NSEC_PER_MSEC);
+	}
+
+	msg->sensor.timestamp_ms = (int64_t) (base_ns / NSEC_PER_MSEC);
+	msg->sensor.network_time = false;
+
+	if (wst_clock_get_network_offset(&offset_ms) == 0) {
+		msg->sensor.timestamp_ms += offset_ms;
+		msg->sensor.network_time = true;
+	}
+}
+
+static void update_rtio_usage(wst_sensor_group_t* group, const wst_sensor_state_t* state, uint32_t buf_len, uint32_t* blocks)
+{
+	*blocks += DIV_ROUND_UP(buf_len, WST_SENSOR_RTIO_BLOCK_SIZE);
+
+	if (buf_len > group->buf_len_hwm) {
+		group->buf_len_hwm = buf_len;
+		LOG_INF("RTIO buffer high-water %u bytes (%s)", buf_len, state->info->name);
+	}
+
+	if (*blocks > group->blocks_hwm) {
+		group->blocks_hwm = *blocks;
+		LOG_INF("RTIO blocks high-water %u of %u (group %u)",
+			*blocks,
+			group->block_count,
+			state->info->acquisition_group
+		);
+	}
+}
+
+//
+// Waits for the next read completion of a group, every completion gives
+// the consume semaphore of its RTIO context once. Returns NULL on timeout,
+// or when the completion was dropped on a full completion queue.
+//
+static struct rtio_cqe* wait_sensor_completion(wst_sensor_group_t* group, k_timeout_t timeout)
+{
+	if (k_sem_take(group->ctx->consume_sem, timeout) != 0) {
+		return NULL;
+	}
+
+	// rtio_cqe_consume() takes the semaphore count of the completion itself
+	k_sem_give(group->ctx->consume_sem);
+	return rtio_cqe_consume(group->ctx);
+}
+
+static uint16_t harvest_sensor_reads(
+	wst_sensor_group_t* group,
+	wst_sensor_value_t* values,
+	uint16_t max_count)
 {
 	int rc;
 	struct rtio_cqe *cqe;
@@ -157,58 +672,713 @@ static uint16_t wst_sensor_get_data(const wst_sensor_config_t* config, sys_slist
 	uint32_t buf_len;
 
 	uint16_t count = 0;
+	uint32_t blocks = 0;
+	uint16_t pending = group->prepared;
+	// Reads are not late before the longest conversion of the group
+	int64_t timeout = k_uptime_get() + group->conversion_ms + CONFIG_WST_SENSOR_READ_TIMEOUT_MS;
 
-	// Non-Blocking read for each sensor
-	for (int i = 0; i < config->sensor_count; i++) {
-		rc = sensor_read_async_mempool(config->iodevs[i], &rtio_ctx, config->iodevs[i]);
-
-		if (rc != 0) {
-			LOG_ERR("sensor_read() failed %d", rc);
-			return count;
+	// Handle read completions in the order they arrive, so that
+	// decoding overlaps transfers still in flight on other buses.
+	// Every completion is consumed and every buffer released, even
+	// on failure, so that the RTIO mempool never leaks.
+	while (pending) {
+		if (atomic_get(&group->cancelled)) {
+			// Poll was abandoned, leave the reads in flight to the next one
+			expire_sensor_reads(group);
+			break;
 		}
-	}
 
-	// Wait for read completions
-	for (int i = 0; i < config->sensor_count; i++) {
-		cqe = rtio_cqe_consume_block(&rtio_ctx);
+		cqe = wait_sensor_completion(group, K_TIMEOUT_ABS_MS(timeout));
 
-		if (cqe->result != 0) {
-			LOG_ERR("async read failed %d", cqe->result);
-			return count;
+		if (!cqe) {
+			if (k_uptime_get() >= timeout) {
+				// Don't wait for hung reads any longer
+				expire_sensor_reads(group);
+				break;
+			}
+			continue;
 		}
 
+		// Each completion renews the deadline of the reads still in flight
+		timeout = k_uptime_get() + CONFIG_WST_SENSOR_READ_TIMEOUT_MS;
+
+		const wst_sensor_read_t* read = (const wst_sensor_read_t*) cqe->userdata;
+		wst_sensor_state_t* state = read->state;
+		int result = cqe->result;
+
 		// Get the associated mempool buffer with the completion
-		rc = rtio_cqe_get_mempool_buffer(&rtio_ctx, cqe, &buf, &buf_len);
+		rc = rtio_cqe_get_mempool_buffer(group->ctx, cqe, &buf, &buf_len);
+
+		// Done with the completion event, release it
+		rtio_cqe_release(group->ctx, cqe);
 
 		if (rc != 0) {
-			LOG_ERR("get mempool buffer failed %d", rc);
-			return count;
+			buf = NULL;
 		}
 
-		const struct sensor_read_config* read_config =
-			(const struct sensor_read_config *)
-				((struct rtio_iodev *)cqe->userdata)->data;
+		if (discard_late_read(group, read, buf, buf_len)) {
+			continue;
+		}
 
-		LOG_DBG("sensor_read_config: count - %u", read_config->count);
+		state->pending = false;
+		pending--;
 
-		// Done with the completion event, release it
-		rtio_cqe_release(&rtio_ctx, cqe);
+		if (buf) {
+			update_rtio_usage(group, state, buf_len, &blocks);
+		}
 
-		rc = decode_sensor_data(values, read_config, buf);
-		if (rc <= 0) {
-			LOG_ERR("decode_sensor_data failed %d", rc);
-			return count;
+		if (result == -ECANCELED) {
+			// Chain was aborted by a failed read ahead of this one,
+			// this sensor is retried on its next deadline.
+			LOG_WRN("%s read canceled", state->info->name);
+		} else if (result != 0) {
+			LOG_ERR("%s async read failed %d", state->info->name, result);
+			atomic_inc(&failure_stats.read);
+			rc = result;
+		} else if (!buf) {
+			LOG_ERR("%s get mempool buffer failed %d", state->info->name, rc);
+			atomic_inc(&failure_stats.buffer);
 		} else {
-			count += (uint16_t) rc;
+			uint32_t errors;
+
+			// Message is not touched once the poll is abandoned
+			k_mutex_lock(&group->lock, K_FOREVER);
+
+			if (atomic_get(&group->cancelled)) {
+				rc = 0;
+				errors = 0;
+			} else {
+				rc = wst_sensor_decode(state->plan, state->reads, buf, values + count, max_count - count, &errors);
+			}
+
+			k_mutex_unlock(&group->lock);
+			atomic_add(&failure_stats.decode, errors);
+
+			if (rc < 0) {
+				LOG_ERR("%s decode failed %d", state->info->name, rc);
+				atomic_inc(&failure_stats.decode);
+			} else {
+				count += (uint16_t) rc;
+				rc = 0;
+			}
+			state->reads++;
+		}
+
+		if (buf) {
+			// Done with the buffer, release it
+			rtio_release_buffer(group->ctx, buf, buf_len);
+		}
+
+		if (result == -ECANCELED) {
+			continue;
+		}
+
+		if (rc == 0) {
+			sensor_succeeded(state);
+		} else {
+			sensor_failed(state, rc);
+		}
+	}
+
+	return count;
+}
+
+static void acquire_group(wst_sensor_group_t* group)
+{
+	// Unchained reads are all started here, so that their conversions
+	// overlap, completions are harvested as each one finishes
+	rtio_submit(group->ctx, 0);
+
+	// Decode into the region of the message reserved for this group
+	uint16_t count = harvest_sensor_reads(
+		group,
+		group->values + group->first,
+		group->max_count
+	);
+
+	k_mutex_lock(&group->lock, K_FOREVER);
+
+	if (!atomic_get(&group->cancelled)) {
+		group->count = count;
+	}
+
+	k_mutex_unlock(&group->lock);
+}
+
+#if (WST_SENSOR_GROUP_COUNT > 1)
+static void group_thread_entry(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	wst_sensor_group_t* group = (wst_sensor_group_t*) p1;
+
+	while (1) {
+		k_sem_take(&group->start, K_FOREVER);
+
+		acquire_group(group);
+
+		k_sem_give(&group->done);
+	}
+}
+#endif
+
+#if (WST_SENSOR_GROUP_COUNT > 1)
+static void start_group_thread(int index)
+{
+	k_thread_create(
+		&wst_sensor_group_threads[index - 1],
+		wst_sensor_group_stacks[index - 1],
+		K_THREAD_STACK_SIZEOF(wst_sensor_group_stacks[index - 1]),
+		group_thread_entry,
+		&sensor_groups[index],
+		NULL,
+		NULL,
+		k_thread_priority_get(k_current_get()),
+		K_INHERIT_PERMS,
+		K_NO_WAIT);
+}
+
+//
+// Abandons the poll of a stuck worker, the worker is not aborted as it may
+// hold a bus or RTIO resources. It exits its harvest on its own, and is
+// not started again until it is done.
+//
+static void abandon_group(int index, int64_t stalled_at)
+{
+	wst_sensor_group_t* group = &sensor_groups[index];
+
+	LOG_ERR("group %u stuck, poll abandoned", index);
+	atomic_inc(&stall_stats.stalls);
+
+	// Worker must not touch the message once the poll is published
+	k_mutex_lock(&group->lock, K_FOREVER);
+
+	atomic_set(&group->cancelled, 1);
+	group->count = 0;
+
+	k_mutex_unlock(&group->lock);
+
+	group->stuck = true;
+	record_stall("acquisition", stalled_at);
+}
+#endif
+
+static void init_groups(void)
+{
+	for (int i = 0; i < WST_SENSOR_GROUP_COUNT; i++) {
+		wst_sensor_group_t* group = &sensor_groups[i];
+
+		group->ctx = group_rtio_ctxs[i];
+		group->block_count = group_block_counts[i];
+		k_sem_init(&group->start, 0, 1);
+		k_sem_init(&group->done, 0, 1);
+		k_mutex_init(&group->lock);
+	}
+
+	// Reserve message values for every channel of each group's sensors
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		sensor_states[i].group->sensor_count++;
+		sensor_states[i].group->max_count += sensor_states[i].plan->channel_count;
+	}
+
+	for (int i = 1; i < WST_SENSOR_GROUP_COUNT; i++) {
+		sensor_groups[i].first = sensor_groups[i - 1].first + sensor_groups[i - 1].max_count;
+	}
+
+	for (int i = 0; i < WST_SENSOR_GROUP_COUNT; i++) {
+		LOG_INF("RTIO of group %u sized for %u sensors, %u blocks of %u bytes",
+			i,
+			sensor_groups[i].sensor_count,
+			sensor_groups[i].block_count,
+			WST_SENSOR_RTIO_BLOCK_SIZE
+		);
+	}
+
+#if (WST_SENSOR_GROUP_COUNT > 1)
+	for (int i = 1; i < WST_SENSOR_GROUP_COUNT; i++) {
+		start_group_thread(i);
+	}
+	LOG_INF("SENSOR group threads are created");
+#endif
+}
+
+static uint16_t acquire_sensor_data(wst_sensor_value_t* values)
+{
+	uint16_t started = 0;
+	uint16_t count = 0;
+
+	// Acquire groups in parallel, group 0 on the calling thread
+	for (int i = 0; i < WST_SENSOR_GROUP_COUNT; i++) {
+		sensor_groups[i].values = values;
+		sensor_groups[i].count = 0;
+
+		if ((i > 0) && sensor_groups[i].prepared) {
+			atomic_set(&sensor_groups[i].cancelled, 0);
+			k_sem_give(&sensor_groups[i].start);
+			started++;
+		}
+	}
+
+	int64_t watchdog = k_uptime_get() + CONFIG_WST_SENSOR_WATCHDOG_MS;
+
+	acquire_group(&sensor_groups[0]);
+
+	// Poll latency is set by the slowest group, the poll of a group
+	// not done before the watchdog expires is abandoned
+	for (int i = 1; (i < WST_SENSOR_GROUP_COUNT) && started; i++) {
+		if (!sensor_groups[i].prepared) {
+			continue;
+		}
+
+		if (k_sem_take(&sensor_groups[i].done, K_TIMEOUT_ABS_MS(watchdog)) != 0) {
+#if (WST_SENSOR_GROUP_COUNT > 1)
+			abandon_group(i, watchdog - CONFIG_WST_SENSOR_WATCHDOG_MS);
+#endif
 		}
+		started--;
+	}
+
+	// Pack values of all groups at the start of the message
+	for (int i = 0; i < WST_SENSOR_GROUP_COUNT; i++) {
+		const wst_sensor_group_t* group = &sensor_groups[i];
+
+		if (group->count && (group->first != count)) {
+			memmove(&values[count], &values[group->first], sizeof(wst_sensor_value_t) * group->count);
+		}
+		count += group->count;
+	}
+
+	return count;
+}
+
+#if defined(CONFIG_WST_SENSOR_BURST)
+//
+// Burst filter of each channel slot, burst reads after the first one are
+// decoded into scratch values and only the filtered value is published
+//
+static wst_sensor_filter_t sensor_filters[WST_SENSOR_CHANNEL_COUNT];
+static wst_sensor_value_t burst_values[WST_SENSOR_CHANNEL_COUNT];
+static uint32_t get_burst_sensors(uint32_t sensors, uint8_t reads)
+{
+	uint32_t burst = 0;
+
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		if ((sensors & BIT(i)) && (sensor_states[i].info->burst_count > reads)) {
+			burst |= BIT(i);
+		}
+	}
+	return burst;
+}
+
+static bool is_burst_value(const wst_sensor_value_t* value, uint32_t burst)
+{
+	return (burst & BIT(wst_sensor_get_slot_sensor(value->slot))) &&
+		(wst_sensor_format_scalar == wst_sensor_get_channel_format(value->spec.chan_type));
+}
+
+static void filter_sensor_values(const wst_sensor_value_t* values, uint16_t count, uint32_t burst)
+{
+	for (uint16_t i = 0; i < count; i++) {
+		const wst_sensor_value_t* value = &values[i];
+
+		if (is_burst_value(value, burst)) {
+			wst_sensor_filter_push(
+				&sensor_filters[value->slot],
+				value->data.q31_data.readings[0].value,
+				value->data.q31_data.shift
+			);
+		}
+	}
+}
+
+static void burst_sensor_data(wst_sensor_value_t* values, uint16_t count, uint32_t due)
+{
+	uint32_t burst = get_burst_sensors(due, 1);
+	uint32_t reads[WST_SENSOR_COUNT];
+
+	if (!burst) {
+		return;
+	}
+
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		reads[i] = sensor_states[i].reads;
+	}
+
+	for (uint16_t i = 0; i < count; i++) {
+		wst_sensor_filter_start(&sensor_filters[values[i].slot]);
+	}
+	filter_sensor_values(values, count, burst);
+
+	// Read back to back the sensors with burst reads left, values
+	// missing from a burst read are filtered from the rest of the burst
+	for (uint8_t n = 1; burst; burst = get_burst_sensors(burst, ++n)) {
+		// Each burst read decodes the channels of the poll's first read
+		for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+			if (burst & BIT(i)) {
+				sensor_states[i].reads = reads[i] - 1;
+			}
+		}
+
+		prepare_sensor_reads(burst);
+
+		uint16_t burst_count = acquire_sensor_data(burst_values);
+
+		filter_sensor_values(burst_values, burst_count, burst);
+	}
+
+	// Channel decimation counts polls, not burst reads
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		sensor_states[i].reads = reads[i];
+	}
+
+	// Filtered value keeps the capture time of the first read
+	burst = get_burst_sensors(due, 1);
 
-		// Done with the buffer, release it
-		rtio_release_buffer(&rtio_ctx, buf, buf_len);
+	for (uint16_t i = 0; i < count; i++) {
+		wst_sensor_value_t* value = &values[i];
+		q31_t q;
+		int8_t shift;
+
+		if (is_burst_value(value, burst) &&
+			wst_sensor_filter_get(
+				&sensor_filters[value->slot],
+				sensor_states[wst_sensor_get_slot_sensor(value->slot)].info->burst_filter,
+				&q, &shift)) {
+			value->data.q31_data.readings[0].value = q;
+			value->data.q31_data.shift = shift;
+		}
 	}
+}
+#endif
 
+//
+// Appends derived channels of the sensors read, computed from their
+// published, possibly burst filtered, values
+//
+static uint16_t derive_sensor_data(wst_sensor_value_t* values, uint16_t count, uint32_t due)
+{
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		if (due & BIT(i)) {
+			count = wst_sensor_derive(
+				sensor_states[i].info,
+				sensor_states[i].plan,
+				values,
+				count,
+				WST_SENSOR_CHANNEL_COUNT
+			);
+		}
+	}
 	return count;
 }
 
+#if defined(CONFIG_WST_SENSOR_STREAM)
+
+//
+// Streaming sensors falling back to polling
+//
+static atomic_t streams_stopped;
+
+RTIO_DEFINE_WITH_MEMPOOL(
+	rtio_stream_ctx,
+	WST_SENSOR_COUNT,
+	WST_SENSOR_COUNT,
+	WST_SENSOR_STREAM_BLOCK_COUNT,
+	WST_SENSOR_STREAM_BLOCK_SIZE,
+	sizeof(void *)
+);
+
+K_THREAD_STACK_DEFINE(wst_sensor_stream_stack, WST_SENSOR_STREAM_STACKSIZE);
+static struct k_thread wst_sensor_stream_thread;
+
+//
+// Restarts a failed stream after its backoff, until the sensor keeps
+// failing for too long. It is then polled instead.
+//
+static void retry_sensor_stream(wst_sensor_state_t* state)
+{
+	if (state->failures < BIT(WST_SENSOR_BACKOFF_MAX_SHIFT)) {
+		state->stream_restart_at = k_uptime_get() +
+			(int64_t) WST_SENSOR_STREAM_RETRY_MS * get_backoff_periods(state);
+		return;
+	}
+
+	LOG_ERR("%s streaming stopped, polling instead", state->info->name);
+
+	state->stream_restart_at = INT64_MAX;
+	state->streaming = false;
+
+	// SENSOR thread schedules the sensor again
+	atomic_set(&streams_stopped, 1);
+	k_sem_give(&wakeup_sem);
+}
+
+static void start_sensor_stream(wst_sensor_state_t* state)
+{
+	struct rtio_sqe* handle;
+
+	state->stream_restart_at = INT64_MAX;
+
+	int rc = sensor_stream(state->stream_iodev, &rtio_stream_ctx, state, &handle);
+	if (rc != 0) {
+		LOG_ERR("%s sensor_stream() failed %d", state->info->name, rc);
+		atomic_inc(&failure_stats.submit);
+		sensor_failed(state, rc);
+		retry_sensor_stream(state);
+	}
+}
+
+static int64_t restart_sensor_streams(void)
+{
+	int64_t now = k_uptime_get();
+	int64_t next = INT64_MAX;
+
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		wst_sensor_state_t* state = &sensor_states[i];
+
+		if (!state->streaming) {
+			continue;
+		}
+
+		if (state->stream_restart_at <= now) {
+			LOG_INF("%s restarting stream", state->info->name);
+			start_sensor_stream(state);
+		}
+		next = MIN(next, state->stream_restart_at);
+	}
+	return next;
+}
+
+static void publish_stream_data(wst_sensor_state_t* state, const uint8_t* buf)
+{
+	uint16_t total = wst_sensor_decode_get_count(state->plan, buf);
+	uint16_t max_count = MIN(total, CONFIG_WST_SENSOR_STREAM_MAX_VALUES);
+	uint32_t errors;
+
+	if (!max_count) {
+		return;
+	}
+
+	if (total > max_count) {
+		LOG_WRN("%s dropping %u of %u frames", state->info->name, total - max_count, total);
+	}
+
+	wst_event_msg_t* msg = sys_heap_alloc(
+		&events_pool,
+		sizeof(wst_event_msg_t) + sizeof(wst_sensor_value_t) * max_count
+	);
+
+	if (!msg) {
+		// Keep streaming, next FIFO buffer may fit
+		LOG_WRN("couldn't alloc memory from shared pool");
+		return;
+	}
+
+	int rc = wst_sensor_decode(state->plan, 0, buf, msg->sensor.values, max_count, &errors);
+	atomic_add(&failure_stats.decode, errors);
+
+	if (rc > 0) {
+		msg->event = wst_event_sensor_data_available;
+		msg->sensor.count = (uint16_t) rc;
+		stamp_sensor_data(msg);
+
+		// FIFO batch spans many client intervals, so it goes to every
+		// subscribed client instead of being gated like a polled sample
+		wst_sensor_client_publish(msg, BIT(state - sensor_states));
+	} else {
+		sys_heap_free(&events_pool, msg);
+	}
+}
+
+static void stream_thread_entry(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	LOG_INF("SENSOR stream thread entered");
+
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		if (sensor_states[i].streaming) {
+			start_sensor_stream(&sensor_states[i]);
+		}
+	}
+
+	while (1) {
+		uint8_t *buf;
+		uint32_t buf_len;
+
+		int64_t restart_at = restart_sensor_streams();
+
+		// Wait for FIFO watermark data of any streaming sensor,
+		// or for the restart of a failed stream
+		k_timeout_t timeout = (restart_at == INT64_MAX) ? K_FOREVER : K_TIMEOUT_ABS_MS(restart_at);
+
+		if (k_sem_take(rtio_stream_ctx.consume_sem, timeout) != 0) {
+			continue;
+		}
+
+		// rtio_cqe_consume() takes the semaphore count of the completion itself
+		k_sem_give(rtio_stream_ctx.consume_sem);
+
+		struct rtio_cqe *cqe = rtio_cqe_consume(&rtio_stream_ctx);
+
+		if (!cqe) {
+			continue;
+		}
+
+		wst_sensor_state_t* state = (wst_sensor_state_t*) cqe->userdata;
+		int result = cqe->result;
+
+		int rc = rtio_cqe_get_mempool_buffer(&rtio_stream_ctx, cqe, &buf, &buf_len);
+
+		rtio_cqe_release(&rtio_stream_ctx, cqe);
+
+		if (rc != 0) {
+			buf = NULL;
+		}
+
+		if (result != 0) {
+			LOG_ERR("%s stream failed %d", state->info->name, result);
+			atomic_inc(&failure_stats.read);
+			sensor_failed(state, result);
+		} else if (!buf) {
+			LOG_ERR("%s get mempool buffer failed %d", state->info->name, rc);
+			atomic_inc(&failure_stats.buffer);
+			sensor_failed(state, rc);
+		} else {
+			publish_stream_data(state, buf);
+			sensor_succeeded(state);
+		}
+
+		if (buf) {
+			rtio_release_buffer(&rtio_stream_ctx, buf, buf_len);
+		}
+
+		if (result != 0) {
+			// Failed stream request is not re-armed by RTIO
+			retry_sensor_stream(state);
+		}
+	}
+}
+
+static bool is_stream_supported(const wst_sensor_state_t* state)
+{
+	const struct sensor_driver_api* api = state->info->sensor_device->api;
+
+	// Streaming is only served by drivers with native RTIO support
+	return api->submit != NULL;
+}
+
+#endif
+
+typedef enum wst_sensor_wakeup {
+	wst_sensor_wakeup_deadline,
+	wst_sensor_wakeup_trigger,
+	wst_sensor_wakeup_intervals,
+} wst_sensor_wakeup_t;
+
+//
+// Waits for the deadline, or for a sensor trigger or client intervals
+// change, whichever comes first
+//
+static wst_sensor_wakeup_t wait_for_deadline(int64_t deadline)
+{
+	k_timeout_t timeout = (deadline == INT64_MAX) ? K_FOREVER : K_TIMEOUT_ABS_MS(deadline);
+
+	while (k_sem_take(&wakeup_sem, timeout) == 0) {
+#if defined(CONFIG_WST_SENSOR_TRIGGER)
+		if (atomic_get(&trigger_pending)) {
+			return wst_sensor_wakeup_trigger;
+		}
+#endif
+		if (wst_sensor_client_intervals_changed()) {
+			return wst_sensor_wakeup_intervals;
+		}
+#if defined(CONFIG_WST_SENSOR_STREAM)
+		if (atomic_clear(&streams_stopped)) {
+			// Sensors no longer streaming are scheduled for polling
+			return wst_sensor_wakeup_intervals;
+		}
+#endif
+	}
+	return wst_sensor_wakeup_deadline;
+}
+
+//
+// Polls each sensor at the shortest interval requested by clients,
+// sensors no client subscribed to are not polled
+//
+static void schedule_sensor(wst_sensor_state_t* state, uint32_t interval_ms, int64_t start)
+{
+	if (state->streaming) {
+		// Streaming sensors are never due for polling
+		state->schedule.deadline = INT64_MAX;
+	} else if (!interval_ms) {
+		state->schedule.deadline = INT64_MAX;
+		state->schedule.period_ms = 0;
+	} else if ((interval_ms != state->schedule.period_ms) ||
+			(state->schedule.deadline == INT64_MAX)) {
+		schedule_init(&state->schedule, interval_ms, start);
+	}
+}
+
+static void update_sensor_intervals(void)
+{
+	int64_t now = k_uptime_get();
+
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		wst_sensor_state_t* state = &sensor_states[i];
+		uint32_t interval_ms = wst_sensor_client_get_interval(i);
+
+		if (interval_ms != state->schedule.period_ms) {
+			LOG_INF("%s polling interval %u ms", state->info->name, interval_ms);
+		}
+		schedule_sensor(state, interval_ms, now);
+	}
+}
+
+static void drop_sensor_reads(void)
+{
+	// Context of a stuck group is still used by its worker, and has
+	// no reads queued
+	for (int i = 0; i < WST_SENSOR_GROUP_COUNT; i++) {
+		if (!sensor_groups[i].stuck) {
+			rtio_sqe_drop_all(sensor_groups[i].ctx);
+		}
+		sensor_groups[i].prepared = 0;
+	}
+
+	// Reads in flight were submitted, only unsubmitted ones are dropped
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		if (!sensor_states[i].timed_out && !sensor_states[i].group->stuck) {
+			sensor_states[i].pending = false;
+		}
+	}
+}
+
+static int64_t get_next_deadline(void)
+{
+	int64_t deadline = INT64_MAX;
+
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		deadline = MIN(deadline, sensor_states[i].schedule.deadline);
+	}
+	return deadline;
+}
+
+static uint32_t get_due_sensors(int64_t now)
+{
+	uint32_t due = 0;
+
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		if (sensor_states[i].schedule.deadline <= now) {
+			due |= BIT(i);
+		}
+	}
+	return due;
+}
+
 void wst_sensor_thread_entry(void *p1, void *p2, void *p3)
 {
 	ARG_UNUSED(p1);
@@ -226,55 +1396,191 @@ void wst_sensor_thread_entry(void *p1, void *p2, void *p3)
 		k_panic();
 	}
 
+
+	// Application thread is the client of the devicetree polling intervals
+	static wst_sensor_client_t uplink_client;
+
+	wst_sensor_client_init(&wakeup_sem);
+	wst_sensor_client_open(&uplink_client, "uplink", &app_events_queue);
+
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		wst_sensor_client_set_interval(&uplink_client, i, sensor_config->sensors[i]->polling_period_ms);
+	}
+
+	// Intervals are applied below
+	(void) wst_sensor_client_intervals_changed();
+
+	int64_t start = k_uptime_get();
+	bool streaming = false;
+
+	for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+		wst_sensor_state_t* state = &sensor_states[i];
+
+		state->info = sensor_config->sensors[i];
+		state->iodev = sensor_config->iodevs[i];
+		state->stream_iodev = sensor_config->stream_iodevs[i];
+		state->plan = &sensor_config->plans[i];
+		state->group = &sensor_groups[state->info->acquisition_group];
+		state->reads = 0;
+		state->failures = 0;
+
+		for (int j = 0; j < WST_SENSOR_READ_TOKENS; j++) {
+			state->read_tokens[j].state = state;
+		}
+
+		state->health = wst_sensor_health_ok;
+		state->streaming = false;
+
+		if (!device_is_ready(state->info->sensor_device)) {
+			// Keep the other sensors going, re-probe this one in background
+			LOG_WRN("%s offline, re-probing", state->info->name);
+			state->health = wst_sensor_health_offline;
+		}
+
+		// Common start time keeps equal period boundaries in phase
+		state->schedule.deadline = INT64_MAX;
+		state->schedule.period_ms = 0;
+		schedule_sensor(state, wst_sensor_client_get_interval(i), start);
+
+#if defined(CONFIG_WST_SENSOR_STREAM)
+		if (state->stream_iodev) {
+			if (state->health == wst_sensor_health_offline) {
+				// Stream is not re-armed on probing, poll the sensor instead
+				LOG_WRN("%s offline, polling instead of streaming", state->info->name);
+			} else if (is_stream_supported(state)) {
+				// Streaming sensors are never due for polling
+				state->streaming = true;
+				schedule_sensor(state, 0, start);
+				streaming = true;
+			} else {
+				LOG_WRN("%s does not support streaming, polling instead", state->info->name);
+			}
+		}
+#endif
+
+#if defined(CONFIG_WST_SENSOR_TRIGGER)
+		if ((state->info->trigger_type != WST_SENSOR_TRIGGER_NONE) &&
+			(state->health != wst_sensor_health_offline) && !state->streaming) {
+			set_sensor_trigger(state);
+		}
+#endif
+	}
+
+	init_groups();
+
+#if defined(CONFIG_WST_SENSOR_STREAM)
+	if (streaming) {
+		k_thread_create(
+			&wst_sensor_stream_thread,
+			wst_sensor_stream_stack,
+			K_THREAD_STACK_SIZEOF(wst_sensor_stream_stack),
+			stream_thread_entry,
+			NULL,
+			NULL,
+			NULL,
+			k_thread_priority_get(k_current_get()),
+			K_INHERIT_PERMS,
+			K_NO_WAIT);
+		LOG_INF("SENSOR stream thread is created");
+	}
+#endif
+
+	int64_t deadline = get_next_deadline();
+	uint32_t due = get_due_sensors(deadline);
+
 	while (1) {
 		uint16_t count = 0;
-		sys_slist_t values_l;
-		
-		sys_slist_init(&values_l);
+
+#if defined(CONFIG_WST_SENSOR_PIPELINE)
+		// Queue next poll's requests before sleeping, so that
+		// a single submit starts all transfers on the deadline.
+		prepare_sensor_reads(due);
+#endif
+
+		// Wait for the next deadline, independent of acquisition time,
+		// or for a sensor trigger, whichever comes first
+		uint32_t scheduled = due;
+		wst_sensor_wakeup_t wakeup = wait_for_deadline(deadline);
+
+		if (wakeup == wst_sensor_wakeup_intervals) {
+			// Reads queued for the deadline may not be due anymore
+#if defined(CONFIG_WST_SENSOR_PIPELINE)
+			drop_sensor_reads();
+#endif
+			update_sensor_intervals();
+
+			deadline = get_next_deadline();
+			due = get_due_sensors(deadline);
+			continue;
+		}
+
+#if defined(CONFIG_WST_SENSOR_TRIGGER) || defined(CONFIG_WST_SENSOR_PIPELINE)
+		bool triggered = (wakeup == wst_sensor_wakeup_trigger);
+#endif
+
+#if defined(CONFIG_WST_SENSOR_TRIGGER)
+		if (triggered) {
+			// Read sensors that fired, and the ones due by now anyway
+			scheduled = get_due_sensors(k_uptime_get());
+			due = scheduled | (uint32_t) atomic_clear(&trigger_pending);
+
+			LOG_DBG("Triggered acquisition 0x%08x", due);
+		}
+#endif
+
+#if defined(CONFIG_WST_SENSOR_PIPELINE)
+		if (triggered) {
+			// Reads queued for the deadline don't match the sensors due
+			drop_sensor_reads();
+			prepare_sensor_reads(due);
+		}
+#else
+		prepare_sensor_reads(due);
+#endif
+
+		// Allocate sensor message to Application thread up front,
+		// so that samples of all groups are decoded in place without
+		// extra copies.
+		wst_event_msg_t* msg = sys_heap_alloc(&events_pool, WST_SENSOR_MSG_SIZE);
+
+		if (!msg) {
+			LOG_ERR("couldn't alloc memory from shared pool");
+			k_panic();
+		}
 
 		// Obtain sensor data
-		count = wst_sensor_get_data(sensor_config, &values_l);
+		count = acquire_sensor_data(msg->sensor.values);
 		if (count) {
 
 			LOG_DBG("Obtained %u sensor values", count);
 
-			// Allocate sensor message to Applicaion thread
-			wst_event_msg_t* msg = sys_heap_alloc(&events_pool,
-				sizeof(wst_event_msg_t) + sizeof(wst_sensor_value_t) * count);
-
-			if (!msg) {
-				LOG_ERR("couldn't alloc memory from shared pool");
-				k_panic();
-			}
+#if defined(CONFIG_WST_SENSOR_BURST)
+			burst_sensor_data(msg->sensor.values, count, due);
+#endif
+			count = derive_sensor_data(msg->sensor.values, count, due);
 
 			// Initialize sensor message
 			msg->event = wst_event_sensor_data_available;
 			msg->sensor.count = count;
+			stamp_sensor_data(msg);
 
-			sys_snode_t *curr, *next = NULL;
-			wst_sensor_value_t* sensor_value = msg->sensor.values;
-
-			// Iterate through sensor values list
-			SYS_SLIST_FOR_EACH_NODE_SAFE(&values_l, curr, next) {
+			// Send sensor message to subscribed clients
+			wst_sensor_client_publish(msg, due & ~scheduled);
+		} else {
+			sys_heap_free(&events_pool, msg);
+		}
 
-				// Remove sensor data node from the list
-				wst_sensor_node_data_t* node = (wst_sensor_node_data_t*) sys_slist_get(&values_l);
-				__ASSERT_NO_MSG(node);
-				LOG_DBG("Added sensor type %u channel %u",
-					node->spec.chan_type,
-					node->spec.chan_idx
+		// Triggered reads don't move polling deadlines
+		for (int i = 0; i < WST_SENSOR_COUNT; i++) {
+			if (scheduled & BIT(i)) {
+				schedule_advance(
+					&sensor_states[i].schedule,
+					get_backoff_periods(&sensor_states[i])
 				);
-				// Copy sensor data
-				sensor_value->spec = node->spec;
-				sensor_value->data = node->data;
-				sensor_value++;
-				free_sensor_data_node(node);
 			}
-
-			// Send sensor message to Application thread
-			k_queue_alloc_append(&app_events_queue, msg);
 		}
 
-		k_sleep(K_MSEC(sensor_config->polling_period_ms));
+		deadline = get_next_deadline();
+		due = get_due_sensors(deadline);
 	}
 }
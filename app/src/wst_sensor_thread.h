@@ -15,6 +15,8 @@
 
 #pragma once
 
-#define WST_SENSOR_STACKSIZE	4096
+#define WST_SENSOR_STACKSIZE			4096
+#define WST_SENSOR_STREAM_STACKSIZE		2048
+#define WST_SENSOR_GROUP_STACKSIZE		2048
 
 void wst_sensor_thread_entry(void *p1, void *p2, void *p3);
@@ -14,10 +14,17 @@
  */
 
 #include "wst_sensor_utils.h"
+#include "wst_cayenne_lpp.h"
+#include "wst_sensor_types.h"
 
 #include <stdlib.h>
+#include <errno.h>
 #include <zephyr/sys/util.h>
 
+#if defined(CONFIG_CMSIS_DSP)
+#include <arm_math.h>
+#endif
+
 static int64_t shifted_q31_to_scaled_int64(q31_t q, int8_t shift, int64_t scale);
 
 const char* wst_sensor_get_channel_name(uint16_t chan_type)
@@ -39,6 +46,14 @@ const char* wst_sensor_get_channel_name(uint16_t chan_type)
 			return "Acceleration";
 		case SENSOR_CHAN_GYRO_XYZ:
 			return "Angular Velocity";
+		case WST_CHANNEL_TYPE_DEW_POINT:
+			return "Dew Point";
+		case WST_CHANNEL_TYPE_SEA_LEVEL_PRESS:
+			return "Sea Level Pressure";
+		case WST_CHANNEL_TYPE_ABS_HUMIDITY:
+			return "Absolute Humidity";
+		case WST_CHANNEL_TYPE_HEAT_INDEX:
+			return "Heat Index";
 	}
 	return "Unknown";
 }
@@ -72,6 +87,28 @@ wst_sensor_format_t wst_sensor_get_channel_format(uint16_t chan_type)
 	}
 }
 
+uint8_t wst_sensor_get_channel_payload_type(uint16_t chan_type)
+{
+	switch (chan_type) {
+		case SENSOR_CHAN_DIE_TEMP:
+		case SENSOR_CHAN_AMBIENT_TEMP:
+		case WST_CHANNEL_TYPE_DEW_POINT:
+		case WST_CHANNEL_TYPE_HEAT_INDEX:
+			return cayenne_lpp_type_temperature_sensor;
+		case SENSOR_CHAN_LIGHT:
+			return cayenne_lpp_type_illuminance_sensor;
+		case SENSOR_CHAN_HUMIDITY:
+			return cayenne_lpp_type_humidity_sensor;
+		case SENSOR_CHAN_PRESS:
+		case WST_CHANNEL_TYPE_SEA_LEVEL_PRESS:
+			return cayenne_lpp_type_barometer;
+		case WST_CHANNEL_TYPE_ABS_HUMIDITY:
+			return cayenne_lpp_type_analog_input;
+		default:
+			return WST_SENSOR_PAYLOAD_NONE;
+	}
+}
+
 void wst_q31_to_sensor_value(q31_t q, int8_t shift, struct sensor_value *val)
 {
 	int64_t micro_value = shifted_q31_to_scaled_int64(q, shift, 1000000LL);
@@ -88,6 +125,108 @@ float wst_q31_to_float(q31_t q, int8_t shift)
 	return sensor_value_to_float(&val);
 }
 
+int64_t wst_q31_to_milli(q31_t q, int8_t shift)
+{
+	return shifted_q31_to_scaled_int64(q, shift, 1000LL);
+}
+
+q31_t wst_milli_to_q31(int64_t milli, int8_t shift)
+{
+	// q = milli * 2^(31 - shift) / 1000, rounded half away from zero
+	int64_t scaled = milli * (int64_t) BIT64(31 - shift);
+	int64_t q = (scaled + ((scaled < 0) ? -500 : 500)) / 1000;
+
+	return (q31_t) CLAMP(q, INT32_MIN, INT32_MAX);
+}
+
+void wst_q31_to_scaled_batch(
+	const q31_t* q,
+	int8_t shift,
+	int64_t scale,
+	int64_t* values,
+	size_t count)
+{
+	// Loops are branch free, so that compilers may vectorize them
+	if (shift <= 31) {
+		int rshift = 31 - shift;
+
+		for (size_t i = 0; i < count; i++) {
+			uint64_t sign = (uint64_t) ((int64_t) q[i] >> 63);
+			uint64_t magnitude = ((uint64_t) (int64_t) q[i] ^ sign) - sign;
+
+			// Truncate magnitude, as the single value conversion does, the
+			// sign is restored unsigned as -2^31 * 2^32 has no positive
+			values[i] = (int64_t) ((((magnitude * (uint64_t) scale) >> rshift) ^ sign) - sign);
+		}
+	} else {
+		int lshift = shift - 31;
+
+		for (size_t i = 0; i < count; i++) {
+			values[i] = (int64_t) q[i] * scale * (int64_t) BIT64(lshift);
+		}
+	}
+}
+
+void wst_q31_to_float_batch(
+	const q31_t* q,
+	int8_t shift,
+	float* values,
+	size_t count)
+{
+	// 2^shift, q31 readings are fractions of it
+	float range = (shift >= 0) ? (float) BIT64(shift) : 1.0f / (float) BIT64(-shift);
+
+#if defined(CONFIG_CMSIS_DSP)
+	arm_q31_to_float(q, values, count);
+	arm_scale_f32(values, range, values, count);
+#else
+	float scale = range / (float) BIT64(31);
+
+	for (size_t i = 0; i < count; i++) {
+		values[i] = (float) q[i] * scale;
+	}
+#endif
+}
+
+int wst_sensor_calibration_init(
+	wst_sensor_calibration_t* calibration,
+	int32_t gain_ppm,
+	int32_t offset_micro)
+{
+	int64_t gain = ((int64_t) gain_ppm * BIT64(WST_SENSOR_CALIBRATION_GAIN_SHIFT)) / 1000000LL;
+
+	if ((gain > INT32_MAX) || (gain < INT32_MIN)) {
+		return -ERANGE;
+	}
+
+	calibration->gain = (int32_t) gain;
+	calibration->offset =
+		((int64_t) offset_micro * BIT64(WST_SENSOR_CALIBRATION_OFFSET_SHIFT)) / 1000000LL;
+	return 0;
+}
+
+q31_t wst_sensor_calibrate_q31(
+	const wst_sensor_calibration_t* calibration,
+	q31_t q,
+	int8_t shift)
+{
+	int64_t value = ((int64_t) q * calibration->gain) >> WST_SENSOR_CALIBRATION_GAIN_SHIFT;
+
+	// Align Q31.32 offset to the q31 value scale of 2^shift
+	int rshift = WST_SENSOR_CALIBRATION_OFFSET_SHIFT - 31 + shift;
+
+	if (rshift >= 0) {
+		value += calibration->offset >> MIN(rshift, 63);
+	} else if ((-rshift < 62) && (llabs(calibration->offset) <= (INT64_MAX >> (1 - rshift)))) {
+		value += calibration->offset * (int64_t) BIT64(-rshift);
+	} else {
+		// Offset is far out of the value range
+		value = (calibration->offset < 0) ? INT32_MIN : INT32_MAX;
+	}
+
+	return (q31_t) CLAMP(value, INT32_MIN, INT32_MAX);
+}
+
 /*
  * Copyright (c) 2023 Intel Corporation.
  *
@@ -18,8 +18,25 @@
 #include <zephyr/dsp/types.h>
 #include <zephyr/drivers/sensor.h>
 
+#include <stddef.h>
 #include <stdint.h>
 
+//
+// Channel payload type value for channels that are not encoded
+//
+#define WST_SENSOR_PAYLOAD_NONE		(0xff)
+
+//
+// Channel calibration, value' = gain * value + offset, in fixed point
+//
+#define WST_SENSOR_CALIBRATION_GAIN_SHIFT	(30)	// gain is Q2.30
+#define WST_SENSOR_CALIBRATION_OFFSET_SHIFT	(32)	// offset is Q31.32
+
+typedef struct wst_sensor_calibration {
+	int32_t gain;
+	int64_t offset;
+} wst_sensor_calibration_t;
+
 typedef enum wst_sensor_format {
 	wst_sensor_format_occurence,
 	wst_sensor_format_3d_vector,
@@ -32,6 +49,82 @@ const char* wst_sensor_get_channel_name(uint16_t chan_type);
 
 wst_sensor_format_t wst_sensor_get_channel_format(uint16_t chan_type);
 
+uint8_t wst_sensor_get_channel_payload_type(uint16_t chan_type);
+
 void wst_q31_to_sensor_value(q31_t q, int8_t shift, struct sensor_value *val);
 
 float wst_q31_to_float(q31_t q, int8_t shift);
+
+int64_t wst_q31_to_milli(q31_t q, int8_t shift);
+
+/**
+ * @brief Converts thousandths of the channel unit to a q31 reading.
+ *
+ * @param[in]  milli       value in thousandths of the channel unit, |milli| < 2^32
+ * @param[in]  shift       shift of the reading, 0 .. 31
+ *
+ * @return q31 reading, rounded and saturated to the range of the shift.
+ */
+q31_t wst_milli_to_q31(int64_t milli, int8_t shift);
+
+/**
+ * @brief Converts array of q31 readings sharing a shift to scaled integers.
+ *
+ * Bit-exact with the single value conversions, e.g. wst_q31_to_milli()
+ * for scale 1000, which take shifts 0 .. 31 only. Values are truncated
+ * toward zero.
+ *
+ * @param[in]  q           q31 readings
+ * @param[in]  shift       shift of the readings, -31 .. 31
+ * @param[in]  scale       scale of the result, e.g. 1000 for thousandths,
+ *                         1 .. 2^32
+ * @param[out] values      scaled values, may not alias readings
+ * @param[in]  count       number of readings
+ */
+void wst_q31_to_scaled_batch(
+	const q31_t* q,
+	int8_t shift,
+	int64_t scale,
+	int64_t* values,
+	size_t count);
+
+/**
+ * @brief Converts array of q31 readings sharing a shift to floats.
+ *
+ * Uses CMSIS-DSP if enabled. Values are exact to float rounding, unlike
+ * wst_q31_to_float() which truncates to millionths first.
+ *
+ * @param[in]  q           q31 readings
+ * @param[in]  shift       shift of the readings, -31 .. 31
+ * @param[out] values      float values, may not alias readings
+ * @param[in]  count       number of readings
+ */
+void wst_q31_to_float_batch(
+	const q31_t* q,
+	int8_t shift,
+	float* values,
+	size_t count);
+
+/**
+ * @brief Initializes channel calibration.
+ *
+ * @param[out] calibration calibration to initialize
+ * @param[in]  gain_ppm    gain in parts per million, 1000000 is unity gain
+ * @param[in]  offset_micro offset in millionths of the channel unit
+ *
+ * @return 0 on success, -ERANGE if gain is not within (-2.0, 2.0).
+ */
+int wst_sensor_calibration_init(
+	wst_sensor_calibration_t* calibration,
+	int32_t gain_ppm,
+	int32_t offset_micro);
+
+/**
+ * @brief Applies calibration to a q31 value with the given shift.
+ *
+ * Result keeps the shift of the input value and saturates to q31 range.
+ */
+q31_t wst_sensor_calibrate_q31(
+	const wst_sensor_calibration_t* calibration,
+	q31_t q,
+	int8_t shift);
@@ -0,0 +1,158 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ *
+ */
+
+#include "wst_cayenne_lpp.h"
+#include "wst_sensor_utils.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/timing/timing.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/util.h>
+
+#include <string.h>
+
+#define BENCHMARK_VALUE_COUNT	(1000)
+
+//
+// Temperature readings as q31 with the shift of BME680 ambient temperature,
+// -40°C .. 85°C
+//
+#define BENCHMARK_SHIFT			(7)
+#define BENCHMARK_MIN_MILLI		(-40000)
+#define BENCHMARK_MAX_MILLI		(85000)
+
+static q31_t readings[BENCHMARK_VALUE_COUNT];
+
+static uint8_t float_payloads[BENCHMARK_VALUE_COUNT][4];
+static uint8_t q31_payloads[BENCHMARK_VALUE_COUNT][4];
+static uint8_t milli_payloads[BENCHMARK_VALUE_COUNT][4];
+
+typedef enum benchmark_path {
+	benchmark_path_float,
+	benchmark_path_q31,
+	benchmark_path_milli,
+} benchmark_path_t;
+
+static void init_readings(void)
+{
+	uint32_t seed = 12345;
+
+	for (int i = 0; i < BENCHMARK_VALUE_COUNT; i++) {
+		// linear congruential generator, same readings on every run
+		seed = seed * 1103515245 + 12345;
+
+		int64_t milli = BENCHMARK_MIN_MILLI +
+			(int64_t) (seed % (BENCHMARK_MAX_MILLI - BENCHMARK_MIN_MILLI));
+
+		readings[i] = (q31_t) (milli * BIT64(31 - BENCHMARK_SHIFT) / 1000);
+	}
+}
+
+static void encode(cayenne_lpp_stream_t* stream, benchmark_path_t path, q31_t q)
+{
+	switch (path) {
+		case benchmark_path_float:
+			{
+			// q31 -> struct sensor_value -> float -> resolution
+			cayenne_lpp_value_t value = {
+				.temperature_sensor.celsius = wst_q31_to_float(q, BENCHMARK_SHIFT)
+			};
+			cayenne_lpp_stream_write(stream, 0, cayenne_lpp_type_temperature_sensor, &value);
+			}
+			break;
+
+		case benchmark_path_q31:
+			// q31 -> resolution
+			cayenne_lpp_stream_write_q31(
+				stream, 0, cayenne_lpp_type_temperature_sensor, q, BENCHMARK_SHIFT);
+			break;
+
+		case benchmark_path_milli:
+			// q31 -> thousandths -> resolution, as aggregated values are sent
+			cayenne_lpp_stream_write_milli(
+				stream, 0, cayenne_lpp_type_temperature_sensor,
+				wst_q31_to_milli(q, BENCHMARK_SHIFT));
+			break;
+	}
+}
+
+static uint64_t run_benchmark(const char* name, benchmark_path_t path, uint8_t payloads[][4])
+{
+	cayenne_lpp_stream_t* stream = cayenne_lpp_stream_new(4, NULL);
+
+	timing_t start = timing_counter_get();
+
+	for (int i = 0; i < BENCHMARK_VALUE_COUNT; i++) {
+		cayenne_lpp_stream_reset(stream);
+		encode(stream, path, readings[i]);
+	}
+
+	timing_t end = timing_counter_get();
+
+	uint64_t cycles = timing_cycles_get(&start, &end);
+
+	// Keep payloads out of the timed loop, for comparison only
+	for (int i = 0; i < BENCHMARK_VALUE_COUNT; i++) {
+		cayenne_lpp_stream_reset(stream);
+		encode(stream, path, readings[i]);
+		memcpy(payloads[i], cayenne_lpp_stream_get_buffer(stream, NULL, NULL), 4);
+	}
+
+	cayenne_lpp_stream_delete(stream);
+
+	printk("%-6s %6u cycles/value, %6u ns/value\n",
+		name,
+		(uint32_t) (cycles / BENCHMARK_VALUE_COUNT),
+		(uint32_t) (timing_cycles_to_ns(cycles) / BENCHMARK_VALUE_COUNT)
+	);
+	return cycles;
+}
+
+static int count_mismatches(uint8_t expected[][4], uint8_t actual[][4])
+{
+	int count = 0;
+
+	for (int i = 0; i < BENCHMARK_VALUE_COUNT; i++) {
+		if (memcmp(expected[i], actual[i], 4)) {
+			count++;
+		}
+	}
+	return count;
+}
+
+int main(void)
+{
+	init_readings();
+
+	timing_init();
+	timing_start();
+
+	printk("Encoding %u temperature values\n", BENCHMARK_VALUE_COUNT);
+
+	run_benchmark("float", benchmark_path_float, float_payloads);
+	run_benchmark("q31", benchmark_path_q31, q31_payloads);
+	run_benchmark("milli", benchmark_path_milli, milli_payloads);
+
+	timing_stop();
+
+	// Float path may round differently within a float ulp of half
+	// resolution steps, integer paths round exact values
+	printk("q31 payloads differing from float: %d\n", count_mismatches(float_payloads, q31_payloads));
+	printk("milli payloads differing from float: %d\n", count_mismatches(float_payloads, milli_payloads));
+
+	printk("WST benchmark completed\n");
+	return 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ *
+ */
+
+#include "wst_sensor_utils.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/timing/timing.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/util.h>
+
+//
+// Accelerometer FIFO sized batch of readings sharing a shift
+//
+#define BENCHMARK_VALUE_COUNT	(1024)
+#define BENCHMARK_SHIFT			(5)
+
+static q31_t readings[BENCHMARK_VALUE_COUNT];
+
+static int64_t single_values[BENCHMARK_VALUE_COUNT];
+static int64_t batch_values[BENCHMARK_VALUE_COUNT];
+
+static float single_floats[BENCHMARK_VALUE_COUNT];
+static float batch_floats[BENCHMARK_VALUE_COUNT];
+
+static void init_readings(void)
+{
+	uint32_t seed = 12345;
+
+	for (int i = 0; i < BENCHMARK_VALUE_COUNT; i++) {
+		// linear congruential generator, same readings on every run
+		seed = seed * 1103515245 + 12345;
+		readings[i] = (q31_t) (seed ^ (seed << 16));
+	}
+}
+
+static void print_cycles(const char* name, timing_t* start, timing_t* end)
+{
+	uint64_t cycles = timing_cycles_get(start, end);
+
+	printk("%-14s %6u cycles/value, %6u ns/value\n",
+		name,
+		(uint32_t) (cycles / BENCHMARK_VALUE_COUNT),
+		(uint32_t) (timing_cycles_to_ns(cycles) / BENCHMARK_VALUE_COUNT)
+	);
+}
+
+int main(void)
+{
+	timing_t start;
+	timing_t end;
+	int mismatches = 0;
+
+	init_readings();
+
+	timing_init();
+	timing_start();
+
+	printk("Converting %u readings, shift %d%s\n",
+		BENCHMARK_VALUE_COUNT,
+		BENCHMARK_SHIFT,
+		IS_ENABLED(CONFIG_CMSIS_DSP) ? ", CMSIS-DSP" : ""
+	);
+
+	start = timing_counter_get();
+	for (int i = 0; i < BENCHMARK_VALUE_COUNT; i++) {
+		single_values[i] = wst_q31_to_milli(readings[i], BENCHMARK_SHIFT);
+	}
+	end = timing_counter_get();
+	print_cycles("milli single", &start, &end);
+
+	start = timing_counter_get();
+	wst_q31_to_scaled_batch(readings, BENCHMARK_SHIFT, 1000, batch_values, BENCHMARK_VALUE_COUNT);
+	end = timing_counter_get();
+	print_cycles("milli batch", &start, &end);
+
+	start = timing_counter_get();
+	for (int i = 0; i < BENCHMARK_VALUE_COUNT; i++) {
+		single_floats[i] = wst_q31_to_float(readings[i], BENCHMARK_SHIFT);
+	}
+	end = timing_counter_get();
+	print_cycles("float single", &start, &end);
+
+	start = timing_counter_get();
+	wst_q31_to_float_batch(readings, BENCHMARK_SHIFT, batch_floats, BENCHMARK_VALUE_COUNT);
+	end = timing_counter_get();
+	print_cycles("float batch", &start, &end);
+
+	timing_stop();
+
+	// Scaled batch is bit-exact, float batch is not truncated to millionths
+	for (int i = 0; i < BENCHMARK_VALUE_COUNT; i++) {
+		if (single_values[i] != batch_values[i]) {
+			mismatches++;
+		}
+	}
+	printk("milli batch values differing from single: %d\n", mismatches);
+
+	float max_error = 0.0f;
+
+	for (int i = 0; i < BENCHMARK_VALUE_COUNT; i++) {
+		float error = batch_floats[i] - single_floats[i];
+
+		max_error = MAX(max_error, (error < 0.0f) ? -error : error);
+	}
+	printk("float batch max difference from single: %d micro\n", (int) (max_error * 1000000.0f));
+
+	if (mismatches) {
+		printk("WST benchmark failed\n");
+		return -1;
+	}
+
+	printk("WST benchmark completed\n");
+	return 0;
+}
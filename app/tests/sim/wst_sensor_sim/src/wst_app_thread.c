@@ -26,6 +26,29 @@
 
 LOG_MODULE_REGISTER(wst_app_thread);
 
+// Three FIFO watermarks of the simulated accelerometer
+#define SIM_STREAM_VALUES	(24)
+
+// Accelerometer values received, they only come from FIFO stream
+// completions as the simulated FIFO sensor rejects one-shot reads
+static uint32_t stream_values;
+
+static void check_stream_data(const wst_event_msg_t* msg)
+{
+	uint32_t count = 0;
+
+	for (uint16_t i = 0; i < msg->sensor.count; i++) {
+		if (SENSOR_CHAN_ACCEL_XYZ == msg->sensor.values[i].spec.chan_type) {
+			count++;
+		}
+	}
+
+	if ((stream_values < SIM_STREAM_VALUES) && (stream_values + count >= SIM_STREAM_VALUES)) {
+		printk("WST simulation run successfully\n");
+	}
+	stream_values += count;
+}
+
 static void log_sensor_data(const wst_event_msg_t* msg)
 {
 	for (uint16_t i = 0; i < msg->sensor.count; i++) {
@@ -89,6 +112,7 @@ static void application_thread(void *p1, void *p2, void *p3)
 		{
 		case wst_event_sensor_data_available:
 			log_sensor_data(msg);
+			check_stream_data(msg);
 			break;
 		
 		default:
@@ -0,0 +1,270 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ *
+ */
+
+//
+// Simulated accelerometer with a FIFO, the only sensor of the simulation
+// served through a native RTIO submit. FIFO watermark buffers complete
+// the stream request of the sensor thread, one-shot reads are rejected
+// so that all of its values come from stream completions.
+//
+
+#define DT_DRV_COMPAT wst_sim_fifo_sensor
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/drivers/sensor_data_types.h>
+#include <zephyr/rtio/rtio.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(wst_sim_fifo_sensor, CONFIG_SENSOR_LOG_LEVEL);
+
+#define SIM_FIFO_SHIFT			(5)				// +/-32 m/s^2 range
+#define SIM_FIFO_STANDARD_GRAVITY	(658113141)	// 9.80665 m/s^2 at SIM_FIFO_SHIFT
+#define SIM_FIFO_DEFAULT_ODR_HZ		(25)
+
+typedef struct sim_fifo_frame {
+	int32_t x;
+	int32_t y;
+	int32_t z;
+} sim_fifo_frame_t;
+
+//
+// FIFO buffer handed over in a stream completion
+//
+typedef struct sim_fifo_encoded {
+	uint64_t timestamp_ns;	// time of the first frame
+	uint32_t period_ns;		// time between frames
+	uint16_t frame_count;
+	sim_fifo_frame_t frames[];
+} sim_fifo_encoded_t;
+
+typedef struct sim_fifo_config {
+	uint16_t watermark;
+} sim_fifo_config_t;
+
+typedef struct sim_fifo_data {
+	const struct device* dev;
+	struct k_work_delayable work;
+	struct k_spinlock lock;
+	struct rtio_iodev_sqe* pending;	// stream request waiting for the watermark
+	uint32_t odr_hz;
+	uint32_t sequence;
+} sim_fifo_data_t;
+
+static int sim_fifo_attr_set(
+	const struct device* dev,
+	enum sensor_channel chan,
+	enum sensor_attribute attr,
+	const struct sensor_value* val)
+{
+	sim_fifo_data_t* data = dev->data;
+
+	if ((chan != SENSOR_CHAN_ACCEL_XYZ) || (attr != SENSOR_ATTR_SAMPLING_FREQUENCY)) {
+		return -ENOTSUP;
+	}
+
+	if (val->val1 <= 0) {
+		return -EINVAL;
+	}
+
+	data->odr_hz = (uint32_t) val->val1;
+	return 0;
+}
+
+static k_timeout_t get_watermark_time(const struct device* dev)
+{
+	const sim_fifo_config_t* config = dev->config;
+	const sim_fifo_data_t* data = dev->data;
+
+	return K_MSEC(config->watermark * MSEC_PER_SEC / data->odr_hz);
+}
+
+static void sim_fifo_submit(const struct device* dev, struct rtio_iodev_sqe* iodev_sqe)
+{
+	const struct sensor_read_config* cfg = iodev_sqe->sqe.iodev->data;
+	sim_fifo_data_t* data = dev->data;
+
+	if (!cfg->is_streaming) {
+		rtio_iodev_sqe_err(iodev_sqe, -ENOTSUP);
+		return;
+	}
+
+	// RTIO re-submits the multishot stream request on each completion
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+	data->pending = iodev_sqe;
+	k_spin_unlock(&data->lock, key);
+
+	k_work_schedule(&data->work, get_watermark_time(dev));
+}
+
+static void sim_fifo_work_handler(struct k_work* work)
+{
+	struct k_work_delayable* dwork = k_work_delayable_from_work(work);
+	sim_fifo_data_t* data = CONTAINER_OF(dwork, sim_fifo_data_t, work);
+	const sim_fifo_config_t* config = data->dev->config;
+
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+	struct rtio_iodev_sqe* iodev_sqe = data->pending;
+	data->pending = NULL;
+	k_spin_unlock(&data->lock, key);
+
+	if (!iodev_sqe) {
+		return;
+	}
+
+	uint32_t buf_len = sizeof(sim_fifo_encoded_t) + config->watermark * sizeof(sim_fifo_frame_t);
+	uint8_t* buf;
+
+	int rc = rtio_sqe_rx_buf(iodev_sqe, buf_len, buf_len, &buf, &buf_len);
+	if (rc != 0) {
+		LOG_ERR("rtio_sqe_rx_buf() failed %d", rc);
+		rtio_iodev_sqe_err(iodev_sqe, rc);
+		return;
+	}
+
+	sim_fifo_encoded_t* encoded = (sim_fifo_encoded_t*) buf;
+	uint32_t period_ns = NSEC_PER_SEC / data->odr_hz;
+
+	encoded->period_ns = period_ns;
+	encoded->frame_count = config->watermark;
+	encoded->timestamp_ns =
+		k_ticks_to_ns_floor64(k_uptime_ticks()) - (uint64_t) (config->watermark - 1) * period_ns;
+
+	// Device at rest, a ramp on the x axis tells the frames apart
+	for (uint16_t i = 0; i < config->watermark; i++) {
+		sim_fifo_frame_t* frame = &encoded->frames[i];
+
+		frame->x = (int32_t) ((data->sequence++ % 64) << 20);
+		frame->y = 0;
+		frame->z = SIM_FIFO_STANDARD_GRAVITY;
+	}
+
+	rtio_iodev_sqe_ok(iodev_sqe, 0);
+}
+
+static int sim_fifo_get_frame_count(
+	const uint8_t* buffer,
+	struct sensor_chan_spec chan_spec,
+	uint16_t* frame_count)
+{
+	const sim_fifo_encoded_t* encoded = (const sim_fifo_encoded_t*) buffer;
+
+	if ((chan_spec.chan_type != SENSOR_CHAN_ACCEL_XYZ) || (chan_spec.chan_idx != 0)) {
+		return -ENOTSUP;
+	}
+
+	*frame_count = encoded->frame_count;
+	return 0;
+}
+
+static int sim_fifo_get_size_info(struct sensor_chan_spec chan_spec, size_t* base_size, size_t* frame_size)
+{
+	if (chan_spec.chan_type != SENSOR_CHAN_ACCEL_XYZ) {
+		return -ENOTSUP;
+	}
+
+	*base_size = sizeof(struct sensor_three_axis_data);
+	*frame_size = sizeof(struct sensor_three_axis_sample_data);
+	return 0;
+}
+
+static int sim_fifo_decode(
+	const uint8_t* buffer,
+	struct sensor_chan_spec chan_spec,
+	uint32_t* fit,
+	uint16_t max_count,
+	void* data_out)
+{
+	const sim_fifo_encoded_t* encoded = (const sim_fifo_encoded_t*) buffer;
+	struct sensor_three_axis_data* out = data_out;
+	uint16_t count = 0;
+
+	if ((chan_spec.chan_type != SENSOR_CHAN_ACCEL_XYZ) || (chan_spec.chan_idx != 0)) {
+		return -ENOTSUP;
+	}
+
+	if (*fit >= encoded->frame_count) {
+		return 0;
+	}
+
+	out->header.base_timestamp_ns = encoded->timestamp_ns + (uint64_t) *fit * encoded->period_ns;
+	out->shift = SIM_FIFO_SHIFT;
+
+	while ((*fit < encoded->frame_count) && (count < max_count)) {
+		const sim_fifo_frame_t* frame = &encoded->frames[*fit];
+
+		out->readings[count].timestamp_delta = count * encoded->period_ns;
+		out->readings[count].x = frame->x;
+		out->readings[count].y = frame->y;
+		out->readings[count].z = frame->z;
+
+		(*fit)++;
+		count++;
+	}
+
+	out->header.reading_count = count;
+	return count;
+}
+
+static bool sim_fifo_has_trigger(const uint8_t* buffer, enum sensor_trigger_type trigger)
+{
+	ARG_UNUSED(buffer);
+
+	return SENSOR_TRIG_FIFO_WATERMARK == trigger;
+}
+
+static const struct sensor_decoder_api sim_fifo_decoder_api = {
+	.get_frame_count = sim_fifo_get_frame_count,
+	.get_size_info = sim_fifo_get_size_info,
+	.decode = sim_fifo_decode,
+	.has_trigger = sim_fifo_has_trigger,
+};
+
+static int sim_fifo_get_decoder(const struct device* dev, const struct sensor_decoder_api** decoder)
+{
+	ARG_UNUSED(dev);
+
+	*decoder = &sim_fifo_decoder_api;
+	return 0;
+}
+
+static const struct sensor_driver_api sim_fifo_api = {
+	.attr_set = sim_fifo_attr_set,
+	.submit = sim_fifo_submit,
+	.get_decoder = sim_fifo_get_decoder,
+};
+
+static int sim_fifo_init(const struct device* dev)
+{
+	sim_fifo_data_t* data = dev->data;
+
+	data->dev = dev;
+	data->odr_hz = SIM_FIFO_DEFAULT_ODR_HZ;
+	k_work_init_delayable(&data->work, sim_fifo_work_handler);
+	return 0;
+}
+
+#define SIM_FIFO_DEFINE(_inst)														\
+	static sim_fifo_data_t sim_fifo_data_##_inst;									\
+	static const sim_fifo_config_t sim_fifo_config_##_inst = {						\
+		.watermark = DT_INST_PROP(_inst, fifo_watermark),							\
+	};																				\
+	SENSOR_DEVICE_DT_INST_DEFINE(_inst, sim_fifo_init, NULL,						\
+		&sim_fifo_data_##_inst, &sim_fifo_config_##_inst,							\
+		POST_KERNEL, CONFIG_SENSOR_INIT_PRIORITY, &sim_fifo_api);
+
+DT_INST_FOREACH_STATUS_OKAY(SIM_FIFO_DEFINE)
@@ -0,0 +1,337 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ *
+ */
+
+#include "wst_cayenne_lpp.h"
+#include "fixture.h"
+
+#include <zephyr/ztest.h>
+#include <zephyr/sys/util.h>
+
+#include <string.h>
+
+
+typedef struct test_vector_fixed_point {
+	const cayenne_lpp_type_t type;
+	const int64_t milli;			// value in thousandths
+	const int8_t shift;				// q31 shift able to represent the value
+} test_vector_fixed_point_t;
+
+static const test_vector_fixed_point_t fixed_point_test_vector[] = {
+	{ .type = cayenne_lpp_type_analog_input,		.milli =       -1000, .shift =  9 },
+	{ .type = cayenne_lpp_type_analog_input,		.milli =           0, .shift =  9 },
+	{ .type = cayenne_lpp_type_analog_input,		.milli =        1000, .shift =  9 },
+	{ .type = cayenne_lpp_type_analog_input,		.milli =      -55000, .shift =  9 },
+	{ .type = cayenne_lpp_type_analog_input,		.milli =      -55400, .shift =  9 },
+	{ .type = cayenne_lpp_type_analog_input,		.milli =      -55500, .shift =  9 },
+	{ .type = cayenne_lpp_type_analog_input,		.milli =      -55600, .shift =  9 },
+	{ .type = cayenne_lpp_type_analog_input,		.milli =      327670, .shift =  9 },
+	{ .type = cayenne_lpp_type_analog_input,		.milli =     -327680, .shift =  9 },
+	{ .type = cayenne_lpp_type_analog_input,		.milli =      327680, .shift =  9 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =       -1000, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =        1000, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =           0, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =       32000, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =       32400, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =       32500, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =       32600, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =       32900, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =       33000, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =      -32400, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =      -32500, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =      -32600, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =     3276700, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =    -3276800, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =     3276800, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =    -3276900, .shift = 12 },
+	{ .type = cayenne_lpp_type_humidity_sensor,		.milli =           0, .shift =  7 },
+	{ .type = cayenne_lpp_type_humidity_sensor,		.milli =       32000, .shift =  7 },
+	{ .type = cayenne_lpp_type_humidity_sensor,		.milli =       32400, .shift =  7 },
+	{ .type = cayenne_lpp_type_humidity_sensor,		.milli =       32500, .shift =  7 },
+	{ .type = cayenne_lpp_type_humidity_sensor,		.milli =       32600, .shift =  7 },
+	{ .type = cayenne_lpp_type_humidity_sensor,		.milli =       32900, .shift =  7 },
+	{ .type = cayenne_lpp_type_humidity_sensor,		.milli =      100000, .shift =  7 },
+	{ .type = cayenne_lpp_type_humidity_sensor,		.milli =      100001, .shift =  7 },
+	{ .type = cayenne_lpp_type_humidity_sensor,		.milli =          -1, .shift =  7 },
+	{ .type = cayenne_lpp_type_barometer,			.milli =           0, .shift = 13 },
+	{ .type = cayenne_lpp_type_barometer,			.milli =      100000, .shift = 13 },
+	{ .type = cayenne_lpp_type_barometer,			.milli =      100400, .shift = 13 },
+	{ .type = cayenne_lpp_type_barometer,			.milli =      100500, .shift = 13 },
+	{ .type = cayenne_lpp_type_barometer,			.milli =      100600, .shift = 13 },
+	{ .type = cayenne_lpp_type_barometer,			.milli =      101000, .shift = 13 },
+	{ .type = cayenne_lpp_type_barometer,			.milli =     6553500, .shift = 13 },
+	{ .type = cayenne_lpp_type_barometer,			.milli =     6553600, .shift = 13 },
+	{ .type = cayenne_lpp_type_barometer,			.milli =       -1000, .shift = 13 },
+	{ .type = cayenne_lpp_type_illuminance_sensor,	.milli =           0, .shift = 17 },
+	{ .type = cayenne_lpp_type_illuminance_sensor,	.milli =      500000, .shift = 17 },
+	{ .type = cayenne_lpp_type_illuminance_sensor,	.milli =      500400, .shift = 17 },
+	{ .type = cayenne_lpp_type_illuminance_sensor,	.milli =      500500, .shift = 17 },
+	{ .type = cayenne_lpp_type_illuminance_sensor,	.milli =      500600, .shift = 17 },
+	{ .type = cayenne_lpp_type_illuminance_sensor,	.milli =      501000, .shift = 17 },
+	{ .type = cayenne_lpp_type_illuminance_sensor,	.milli =    65535000, .shift = 17 },
+	{ .type = cayenne_lpp_type_illuminance_sensor,	.milli =    65535600, .shift = 17 },
+};
+
+// Values in thousandths half way between two encoded values, they are
+// decimal and fall between q31 values, so they only test milli encoding
+static const test_vector_fixed_point_t milli_tie_test_vector[] = {
+	{ .type = cayenne_lpp_type_analog_input,		.milli =      -55455, .shift =  9 },
+	{ .type = cayenne_lpp_type_analog_input,		.milli =       55455, .shift =  9 },
+	{ .type = cayenne_lpp_type_analog_input,		.milli =      -55005, .shift =  9 },
+	{ .type = cayenne_lpp_type_analog_input,		.milli =          -5, .shift =  9 },
+	{ .type = cayenne_lpp_type_analog_input,		.milli =           5, .shift =  9 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =       32450, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =      -32450, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =      -55450, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =         -50, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =          50, .shift = 12 },
+	{ .type = cayenne_lpp_type_humidity_sensor,		.milli =       32250, .shift =  7 },
+	{ .type = cayenne_lpp_type_humidity_sensor,		.milli =       32750, .shift =  7 },
+	{ .type = cayenne_lpp_type_humidity_sensor,		.milli =         250, .shift =  7 },
+	{ .type = cayenne_lpp_type_humidity_sensor,		.milli =       99750, .shift =  7 },
+	{ .type = cayenne_lpp_type_humidity_sensor,		.milli =        -250, .shift =  7 },
+	{ .type = cayenne_lpp_type_barometer,			.milli =      100450, .shift = 13 },
+	{ .type = cayenne_lpp_type_barometer,			.milli =      100050, .shift = 13 },
+	{ .type = cayenne_lpp_type_barometer,			.milli =          50, .shift = 13 },
+	{ .type = cayenne_lpp_type_barometer,			.milli =         -50, .shift = 13 },
+	{ .type = cayenne_lpp_type_illuminance_sensor,	.milli =      500500, .shift = 17 },
+	{ .type = cayenne_lpp_type_illuminance_sensor,	.milli =        1500, .shift = 17 },
+	{ .type = cayenne_lpp_type_illuminance_sensor,	.milli =         500, .shift = 17 },
+	{ .type = cayenne_lpp_type_illuminance_sensor,	.milli =        -500, .shift = 17 },
+	{ .type = cayenne_lpp_type_illuminance_sensor,	.milli =    65534500, .shift = 17 },
+};
+
+// Dyadic values half way between two encoded values, their q31 values
+// are exact, so the float reference sees the same tie
+static const test_vector_fixed_point_t q31_tie_test_vector[] = {
+	{ .type = cayenne_lpp_type_analog_input,		.milli =       55125, .shift =  9 },
+	{ .type = cayenne_lpp_type_analog_input,		.milli =      -55125, .shift =  9 },
+	{ .type = cayenne_lpp_type_analog_input,		.milli =         125, .shift =  9 },
+	{ .type = cayenne_lpp_type_analog_input,		.milli =        -125, .shift =  9 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =       32250, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =       32750, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =      -32250, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =         250, .shift = 12 },
+	{ .type = cayenne_lpp_type_temperature_sensor,	.milli =        -250, .shift = 12 },
+	{ .type = cayenne_lpp_type_humidity_sensor,		.milli =       32250, .shift =  7 },
+	{ .type = cayenne_lpp_type_humidity_sensor,		.milli =       32750, .shift =  7 },
+	{ .type = cayenne_lpp_type_humidity_sensor,		.milli =         250, .shift =  7 },
+	{ .type = cayenne_lpp_type_humidity_sensor,		.milli =       99750, .shift =  7 },
+	{ .type = cayenne_lpp_type_barometer,			.milli =      100250, .shift = 13 },
+	{ .type = cayenne_lpp_type_barometer,			.milli =      100750, .shift = 13 },
+	{ .type = cayenne_lpp_type_barometer,			.milli =         250, .shift = 13 },
+	{ .type = cayenne_lpp_type_illuminance_sensor,	.milli =      500500, .shift = 17 },
+	{ .type = cayenne_lpp_type_illuminance_sensor,	.milli =      499500, .shift = 17 },
+	{ .type = cayenne_lpp_type_illuminance_sensor,	.milli =         500, .shift = 17 },
+	{ .type = cayenne_lpp_type_illuminance_sensor,	.milli =    65534500, .shift = 17 },
+};
+
+static void set_float_value(cayenne_lpp_type_t type, float f, cayenne_lpp_value_t* value)
+{
+	switch (type) {
+		case cayenne_lpp_type_analog_input:
+			value->analog_input = f;
+			break;
+		case cayenne_lpp_type_temperature_sensor:
+			value->temperature_sensor.celsius = f;
+			break;
+		case cayenne_lpp_type_humidity_sensor:
+			value->humidity_sensor.rh = f;
+			break;
+		case cayenne_lpp_type_barometer:
+			value->barometer.hpa = f;
+			break;
+		case cayenne_lpp_type_illuminance_sensor:
+			value->illuminance_sensor.lux = f;
+			break;
+		default:
+			zassert_unreachable("unexpected type %d", type);
+	}
+}
+
+static float q31_to_float(int32_t q, int8_t shift)
+{
+	return (float) ((double) q / (double) (1LL << (31 - shift)));
+}
+
+static int32_t milli_to_q31(int64_t milli, int8_t shift)
+{
+	int64_t den = 1000;
+	int64_t num = milli * (1LL << (31 - shift));
+
+	// round to nearest q31 value
+	return (int32_t) ((num >= 0) ? ((num + den / 2) / den) : -((-num + den / 2) / den));
+}
+
+static void assert_streams_equal(
+	cayenne_lpp_stream_t* expected,
+	cayenne_lpp_stream_t* actual,
+	int i)
+{
+	size_t expected_size;
+	size_t actual_size;
+
+	const uint8_t* expected_buffer = cayenne_lpp_stream_get_buffer(expected, NULL, &expected_size);
+	const uint8_t* actual_buffer = cayenne_lpp_stream_get_buffer(actual, NULL, &actual_size);
+
+	zassert_equal(expected_size, actual_size, "invalid stream size, vector %d", i);
+	zassert_mem_equal(actual_buffer, expected_buffer, actual_size, "invalid encoded data, vector %d", i);
+}
+
+static void assert_milli_encoding(
+	cayenne_lpp_encode_fixture_t* fixture,
+	const test_vector_fixed_point_t* vectors,
+	size_t count)
+{
+	cayenne_lpp_stream_t* expected = cayenne_lpp_stream_new(fixture->max_size, NULL);
+	zassert_not_null(expected, "cayenne_lpp_stream_new() fails");
+
+	for (int i = 0; i < count; i++) {
+		const test_vector_fixed_point_t* vector = &vectors[i];
+		cayenne_lpp_value_t value;
+
+		// reset write pointers
+		cayenne_lpp_stream_reset(expected);
+		cayenne_lpp_stream_reset(fixture->stream);
+
+		set_float_value(vector->type, (float) vector->milli / 1000.0f, &value);
+
+		cayenne_lpp_result_t expected_result =
+			cayenne_lpp_stream_write(expected, i, vector->type, &value);
+
+		cayenne_lpp_result_t result =
+			cayenne_lpp_stream_write_milli(fixture->stream, i, vector->type, vector->milli);
+
+		zassert_equal(expected_result, result, "invalid result, vector %d", i);
+		assert_streams_equal(expected, fixture->stream, i);
+	}
+
+	cayenne_lpp_stream_delete(expected);
+}
+
+static void assert_q31_encoding(
+	cayenne_lpp_encode_fixture_t* fixture,
+	const test_vector_fixed_point_t* vectors,
+	size_t count)
+{
+	cayenne_lpp_stream_t* expected = cayenne_lpp_stream_new(fixture->max_size, NULL);
+	zassert_not_null(expected, "cayenne_lpp_stream_new() fails");
+
+	for (int i = 0; i < count; i++) {
+		const test_vector_fixed_point_t* vector = &vectors[i];
+		int32_t q = milli_to_q31(vector->milli, vector->shift);
+		cayenne_lpp_value_t value;
+
+		// reset write pointers
+		cayenne_lpp_stream_reset(expected);
+		cayenne_lpp_stream_reset(fixture->stream);
+
+		set_float_value(vector->type, q31_to_float(q, vector->shift), &value);
+
+		cayenne_lpp_result_t expected_result =
+			cayenne_lpp_stream_write(expected, i, vector->type, &value);
+
+		cayenne_lpp_result_t result =
+			cayenne_lpp_stream_write_q31(fixture->stream, i, vector->type, q, vector->shift);
+
+		zassert_equal(expected_result, result, "invalid result, vector %d", i);
+		assert_streams_equal(expected, fixture->stream, i);
+	}
+
+	cayenne_lpp_stream_delete(expected);
+}
+
+/**
+ * @brief Test Cayenne LPP fixed point encoding of values in thousandths
+ *
+ * This test verifies that integer encoding of values in thousandths is
+ * bit-exact with float encoding, including out of range handling
+ *
+ */
+ZTEST_F(cayenne_lpp_encode, test_milli_encoding)
+{
+	assert_milli_encoding(fixture, fixed_point_test_vector, ARRAY_SIZE(fixed_point_test_vector));
+}
+
+/**
+ * @brief Test Cayenne LPP fixed point encoding of rounding ties in thousandths
+ *
+ * This test verifies that integer encoding of values in thousandths
+ * half way between two encoded values rounds away from zero as float
+ * encoding does, for each resolution and sign
+ *
+ */
+ZTEST_F(cayenne_lpp_encode, test_milli_rounding_tie)
+{
+	assert_milli_encoding(fixture, milli_tie_test_vector, ARRAY_SIZE(milli_tie_test_vector));
+}
+
+/**
+ * @brief Test Cayenne LPP fixed point encoding of q31 values
+ *
+ * This test verifies that integer encoding of q31 values is bit-exact
+ * with float encoding, including out of range handling
+ *
+ */
+ZTEST_F(cayenne_lpp_encode, test_q31_encoding)
+{
+	assert_q31_encoding(fixture, fixed_point_test_vector, ARRAY_SIZE(fixed_point_test_vector));
+}
+
+/**
+ * @brief Test Cayenne LPP fixed point encoding of q31 rounding ties
+ *
+ * This test verifies that integer encoding of q31 values half way
+ * between two encoded values rounds away from zero as float encoding
+ * does, for each resolution and sign
+ *
+ */
+ZTEST_F(cayenne_lpp_encode, test_q31_rounding_tie)
+{
+	assert_q31_encoding(fixture, q31_tie_test_vector, ARRAY_SIZE(q31_tie_test_vector));
+}
+
+/**
+ * @brief Test Cayenne LPP fixed point encoding of q31 values shifts
+ *
+ * This test verifies q31 encoding of the same value with different shifts
+ *
+ */
+ZTEST_F(cayenne_lpp_encode, test_q31_shift)
+{
+	// 32.5°C
+	const uint8_t output[] = {0x00, 0x67, 0x01, 0x45};
+
+	for (int8_t shift = 6; shift <= 30; shift++) {
+
+		// reset write pointer
+		cayenne_lpp_stream_reset(fixture->stream);
+
+		cayenne_lpp_result_t result = cayenne_lpp_stream_write_q31(
+			fixture->stream,
+			0,
+			cayenne_lpp_type_temperature_sensor,
+			(int32_t) (65LL << (30 - shift)),
+			shift
+		);
+		zassert_equal(cayenne_lpp_result_success, result, "shift %d", shift);
+
+		size_t stream_size;
+		const uint8_t* lpp_buffer = cayenne_lpp_stream_get_buffer(fixture->stream, NULL, &stream_size);
+
+		zassert_equal(sizeof(output), stream_size, "invalid stream size, shift %d", shift);
+		zassert_mem_equal(lpp_buffer, output, stream_size, "invalid encoded data, shift %d", shift);
+	}
+}
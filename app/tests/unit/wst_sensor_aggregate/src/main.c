@@ -0,0 +1,157 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ *
+ */
+
+#include "wst_sensor_aggregate.h"
+
+#include <zephyr/ztest.h>
+#include <zephyr/sys/util.h>
+
+
+ZTEST_SUITE(
+	/* SUITE_NAME */	wst_sensor_aggregate,
+	/* PREDICATE */		NULL,
+	/* setup_fn */		NULL,
+	/* before_fn */		NULL,
+	/* after_fn */		NULL,
+	/* teardown_fn */	NULL
+);
+
+
+static void update_stats(wst_sensor_stats_t* stats, const int64_t* values, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		wst_sensor_stats_update(stats, values[i]);
+	}
+}
+
+/**
+ * @brief Test mean of a step change
+ *
+ * This test verifies that a long window keeps the exact mean,
+ * 300 values at 21.000 and 300 at 21.500 average to 21.250.
+ *
+ */
+ZTEST(wst_sensor_aggregate, test_step_mean)
+{
+	wst_sensor_stats_t stats = {0};
+
+	for (int i = 0; i < 300; i++) {
+		wst_sensor_stats_update(&stats, 21000);
+	}
+
+	for (int i = 0; i < 300; i++) {
+		wst_sensor_stats_update(&stats, 21500);
+	}
+
+	zassert_equal(600, stats.count);
+	zassert_equal(21250, wst_sensor_stats_get(&stats, wst_sensor_statistic_mean));
+	zassert_equal(250, wst_sensor_stats_get_stddev(&stats));
+}
+
+/**
+ * @brief Test mean rounding
+ *
+ * This test verifies that the mean is rounded to the closest
+ * thousandth, away from zero on ties.
+ *
+ */
+ZTEST(wst_sensor_aggregate, test_mean_rounding)
+{
+	static const int64_t positive[] = {1000, 1001};
+	static const int64_t negative[] = {-1000, -1001};
+	static const int64_t thirds[] = {0, 0, 2};
+	wst_sensor_stats_t stats;
+
+	stats = (wst_sensor_stats_t) {0};
+	update_stats(&stats, positive, ARRAY_SIZE(positive));
+	zassert_equal(1001, wst_sensor_stats_get(&stats, wst_sensor_statistic_mean));
+
+	stats = (wst_sensor_stats_t) {0};
+	update_stats(&stats, negative, ARRAY_SIZE(negative));
+	zassert_equal(-1001, wst_sensor_stats_get(&stats, wst_sensor_statistic_mean));
+
+	stats = (wst_sensor_stats_t) {0};
+	update_stats(&stats, thirds, ARRAY_SIZE(thirds));
+	zassert_equal(1, wst_sensor_stats_get(&stats, wst_sensor_statistic_mean));
+}
+
+/**
+ * @brief Test min, max and last
+ *
+ * This test verifies extremes and the last value of a window.
+ *
+ */
+ZTEST(wst_sensor_aggregate, test_min_max_last)
+{
+	static const int64_t values[] = {-5000, 7000, -1000, 2000, -3000};
+	wst_sensor_stats_t stats = {0};
+
+	update_stats(&stats, values, ARRAY_SIZE(values));
+
+	zassert_equal(-5000, wst_sensor_stats_get(&stats, wst_sensor_statistic_min));
+	zassert_equal(7000, wst_sensor_stats_get(&stats, wst_sensor_statistic_max));
+	zassert_equal(-3000, wst_sensor_stats_get(&stats, wst_sensor_statistic_last));
+	zassert_equal(0, wst_sensor_stats_get(&stats, wst_sensor_statistic_mean));
+}
+
+/**
+ * @brief Test standard deviation
+ *
+ * This test verifies sample standard deviation, including windows
+ * of a single value and values far from zero.
+ *
+ */
+ZTEST(wst_sensor_aggregate, test_stddev)
+{
+	static const int64_t values[] = {-5000, 7000, -1000, 2000, -3000};
+	static const int64_t pressure[] = {101325000, 101327000, 101329000};
+	wst_sensor_stats_t stats;
+
+	stats = (wst_sensor_stats_t) {0};
+	wst_sensor_stats_update(&stats, 21000);
+	zassert_equal(0, wst_sensor_stats_get_stddev(&stats));
+
+	// sqrt(88000000 / 4)
+	stats = (wst_sensor_stats_t) {0};
+	update_stats(&stats, values, ARRAY_SIZE(values));
+	zassert_equal(4690, wst_sensor_stats_get_stddev(&stats));
+
+	stats = (wst_sensor_stats_t) {0};
+	update_stats(&stats, pressure, ARRAY_SIZE(pressure));
+	zassert_equal(101327000, wst_sensor_stats_get(&stats, wst_sensor_statistic_mean));
+	zassert_equal(2000, wst_sensor_stats_get_stddev(&stats));
+}
+
+/**
+ * @brief Test saturation of the squared differences
+ *
+ * This test verifies that squared differences of gas resistance in
+ * thousandths of an ohm saturate sum2 instead of wrapping it.
+ *
+ */
+ZTEST(wst_sensor_aggregate, test_sum2_saturation)
+{
+	static const int64_t gas_resistance[] = {10000000, 5000000000000, 10000000};
+	wst_sensor_stats_t stats = {0};
+
+	update_stats(&stats, gas_resistance, ARRAY_SIZE(gas_resistance));
+
+	zassert_equal(WST_SENSOR_STATS_SUM2_SATURATED, stats.sum2);
+	zassert_equal(3, stats.count);
+	zassert_equal(5000000000000, wst_sensor_stats_get(&stats, wst_sensor_statistic_max));
+	// sqrt(UINT64_MAX / 2)
+	zassert_equal(3037000499, wst_sensor_stats_get_stddev(&stats));
+}
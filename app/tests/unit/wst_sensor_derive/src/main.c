@@ -0,0 +1,299 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ *
+ */
+
+#include "wst_sensor_derive.h"
+#include "wst_sensor_types.h"
+#include "wst_sensor_utils.h"
+
+#include <zephyr/ztest.h>
+#include <zephyr/sys/util.h>
+
+#include <string.h>
+
+
+//
+// Expected values are computed in floating point from the formulas the
+// kernels approximate: Magnus saturation pressure, ideal gas law of water
+// vapour, hypsometric equation and NWS heat index.
+//
+
+#define SLOT_TEMP			(0)
+#define SLOT_HUMIDITY		(1)
+#define SLOT_PRESS			(2)
+#define SLOT_DEW_POINT		(3)
+#define SLOT_SEA_LEVEL		(4)
+#define SLOT_ABS_HUMIDITY	(5)
+#define SLOT_HEAT_INDEX		(6)
+
+#define SOURCE_SHIFT		(7)
+#define VALUE_COUNT			(8)
+#define NO_VALUE			INT64_MIN
+
+static const wst_sensor_channel_plan_t channels[] = {
+	{ .spec = { .chan_type = SENSOR_CHAN_AMBIENT_TEMP }, .slot = SLOT_TEMP },
+	{ .spec = { .chan_type = SENSOR_CHAN_HUMIDITY }, .slot = SLOT_HUMIDITY },
+	{ .spec = { .chan_type = SENSOR_CHAN_PRESS }, .slot = SLOT_PRESS },
+};
+
+static const wst_sensor_channel_plan_t derived[] = {
+	{ .spec = { .chan_type = WST_CHANNEL_TYPE_DEW_POINT }, .slot = SLOT_DEW_POINT },
+	{ .spec = { .chan_type = WST_CHANNEL_TYPE_SEA_LEVEL_PRESS }, .slot = SLOT_SEA_LEVEL },
+	{ .spec = { .chan_type = WST_CHANNEL_TYPE_ABS_HUMIDITY }, .slot = SLOT_ABS_HUMIDITY },
+	{ .spec = { .chan_type = WST_CHANNEL_TYPE_HEAT_INDEX }, .slot = SLOT_HEAT_INDEX },
+};
+
+static const wst_sensor_plan_t plan = {
+	.channel_count = ARRAY_SIZE(channels),
+	.channels = channels,
+	.derived_count = ARRAY_SIZE(derived),
+	.derived = derived,
+};
+
+static const wst_sensor_info_t sensor = {
+	.name = "env",
+	.altitude_m = 500,
+};
+
+static wst_sensor_value_t values[VALUE_COUNT];
+static uint16_t count;
+
+static void derive_suite_before(void *f)
+{
+	ARG_UNUSED(f);
+
+	memset(values, 0, sizeof(values));
+	count = 0;
+}
+
+ZTEST_SUITE(
+	/* SUITE_NAME */	wst_sensor_derive,
+	/* PREDICATE */		NULL,
+	/* setup_fn */		NULL,
+	/* before_fn */		derive_suite_before,
+	/* after_fn */		NULL,
+	/* teardown_fn */	NULL
+);
+
+
+static void add_source(uint16_t slot, int32_t milli)
+{
+	wst_sensor_value_t* value = &values[count++];
+
+	value->spec = channels[slot].spec;
+	value->slot = slot;
+	value->data.q31_data.header.reading_count = 1;
+	value->data.q31_data.shift = SOURCE_SHIFT;
+	value->data.q31_data.readings[0].value = wst_milli_to_q31(milli, SOURCE_SHIFT);
+}
+
+static void derive(const wst_sensor_info_t* info, uint16_t max_count)
+{
+	count = wst_sensor_derive(info, &plan, values, count, max_count);
+}
+
+static int64_t get_derived(uint16_t slot)
+{
+	for (uint16_t i = 0; i < count; i++) {
+		const wst_sensor_value_t* value = &values[i];
+
+		if (value->slot == slot) {
+			return wst_q31_to_milli(
+				value->data.q31_data.readings[0].value,
+				value->data.q31_data.shift
+			);
+		}
+	}
+	return NO_VALUE;
+}
+
+typedef struct test_vector_derive {
+	int32_t temp;			// m°C
+	int32_t humidity;		// m%RH
+	int32_t expected;		// thousandths of the derived channel unit
+} test_vector_derive_t;
+
+static void test_humidity_channel(
+	const test_vector_derive_t* vector,
+	size_t vector_count,
+	uint16_t slot,
+	int32_t tolerance)
+{
+	for (size_t i = 0; i < vector_count; i++) {
+		derive_suite_before(NULL);
+		add_source(SLOT_TEMP, vector[i].temp);
+		add_source(SLOT_HUMIDITY, vector[i].humidity);
+		derive(&sensor, VALUE_COUNT);
+
+		zassert_within(vector[i].expected, get_derived(slot), tolerance,
+			"vector %u: %d m°C %d m%%RH", (unsigned int) i, vector[i].temp, vector[i].humidity);
+	}
+}
+
+/**
+ * @brief Test dew point
+ *
+ * This test verifies dew point against the Magnus formula, below
+ * freezing and for saturated air.
+ *
+ */
+ZTEST(wst_sensor_derive, test_dew_point)
+{
+	static const test_vector_derive_t vector[] = {
+		{ .temp =  20000, .humidity =  50000, .expected =   9255 },
+		{ .temp =  25000, .humidity =  80000, .expected =  21307 },
+		{ .temp = -10000, .humidity =  90000, .expected = -11329 },
+		{ .temp =  15000, .humidity = 100000, .expected =  15000 },
+	};
+
+	test_humidity_channel(vector, ARRAY_SIZE(vector), SLOT_DEW_POINT, 50);
+}
+
+/**
+ * @brief Test absolute humidity
+ *
+ * This test verifies absolute humidity against the ideal gas law
+ * of water vapour.
+ *
+ */
+ZTEST(wst_sensor_derive, test_abs_humidity)
+{
+	static const test_vector_derive_t vector[] = {
+		{ .temp =  25000, .humidity =  60000, .expected = 13780 },
+		{ .temp =      0, .humidity = 100000, .expected =  4849 },
+		{ .temp = -10000, .humidity =  90000, .expected =  2127 },
+	};
+
+	test_humidity_channel(vector, ARRAY_SIZE(vector), SLOT_ABS_HUMIDITY, 20);
+}
+
+/**
+ * @brief Test heat index
+ *
+ * This test verifies heat index against the NWS algorithm, below and
+ * above the 80 °F switch to the Rothfusz regression.
+ *
+ */
+ZTEST(wst_sensor_derive, test_heat_index)
+{
+	static const test_vector_derive_t vector[] = {
+		{ .temp = 20000, .humidity = 50000, .expected = 19361 },
+		{ .temp = 32000, .humidity = 70000, .expected = 40409 },
+		{ .temp = 35000, .humidity = 40000, .expected = 37216 },
+		{ .temp = 40000, .humidity = 20000, .expected = 39377 },
+	};
+
+	test_humidity_channel(vector, ARRAY_SIZE(vector), SLOT_HEAT_INDEX, 100);
+}
+
+/**
+ * @brief Test sea level pressure
+ *
+ * This test verifies sea level pressure against the hypsometric
+ * equation at the station elevation, and that it is the station
+ * pressure at sea level.
+ *
+ */
+ZTEST(wst_sensor_derive, test_sea_level_pressure)
+{
+	static const wst_sensor_info_t sea_level = {
+		.name = "sea",
+		.altitude_m = 0,
+	};
+	static const wst_sensor_info_t mountain = {
+		.name = "mountain",
+		.altitude_m = 1500,
+	};
+
+	add_source(SLOT_TEMP, 15000);
+	add_source(SLOT_PRESS, 95000);
+	derive(&sensor, VALUE_COUNT);
+	zassert_within(100768, get_derived(SLOT_SEA_LEVEL), 20);
+
+	derive_suite_before(NULL);
+	add_source(SLOT_TEMP, 15000);
+	add_source(SLOT_PRESS, 101325);
+	derive(&sea_level, VALUE_COUNT);
+	zassert_within(101325, get_derived(SLOT_SEA_LEVEL), 2);
+
+	derive_suite_before(NULL);
+	add_source(SLOT_TEMP, 5000);
+	add_source(SLOT_PRESS, 85000);
+	derive(&mountain, VALUE_COUNT);
+	zassert_within(101872, get_derived(SLOT_SEA_LEVEL), 20);
+}
+
+/**
+ * @brief Test missing and out of range sources
+ *
+ * This test verifies that derived channels are skipped when one of
+ * their sources is missing or out of the range of their kernel.
+ *
+ */
+ZTEST(wst_sensor_derive, test_missing_sources)
+{
+	// Every derived channel depends on temperature
+	add_source(SLOT_HUMIDITY, 50000);
+	add_source(SLOT_PRESS, 95000);
+	derive(&sensor, VALUE_COUNT);
+	zassert_equal(2, count);
+
+	// Pressure only gives sea level pressure
+	derive_suite_before(NULL);
+	add_source(SLOT_TEMP, 15000);
+	add_source(SLOT_PRESS, 95000);
+	derive(&sensor, VALUE_COUNT);
+	zassert_equal(3, count);
+	zassert_not_equal(NO_VALUE, get_derived(SLOT_SEA_LEVEL));
+	zassert_equal(NO_VALUE, get_derived(SLOT_DEW_POINT));
+
+	// No vapour at all has no dew point
+	derive_suite_before(NULL);
+	add_source(SLOT_TEMP, 15000);
+	add_source(SLOT_HUMIDITY, 0);
+	derive(&sensor, VALUE_COUNT);
+	zassert_equal(NO_VALUE, get_derived(SLOT_DEW_POINT));
+	zassert_equal(NO_VALUE, get_derived(SLOT_ABS_HUMIDITY));
+
+	// Beyond the saturation pressure table
+	derive_suite_before(NULL);
+	add_source(SLOT_TEMP, 70000);
+	add_source(SLOT_HUMIDITY, 50000);
+	derive(&sensor, VALUE_COUNT);
+	zassert_equal(NO_VALUE, get_derived(SLOT_DEW_POINT));
+	zassert_equal(NO_VALUE, get_derived(SLOT_ABS_HUMIDITY));
+}
+
+/**
+ * @brief Test capacity of values
+ *
+ * This test verifies that derived values are not appended past
+ * the capacity, and that they keep the source header.
+ *
+ */
+ZTEST(wst_sensor_derive, test_capacity)
+{
+	add_source(SLOT_TEMP, 20000);
+	add_source(SLOT_HUMIDITY, 50000);
+	add_source(SLOT_PRESS, 95000);
+	values[0].data.q31_data.header.base_timestamp_ns = 1000000;
+
+	derive(&sensor, 5);
+	zassert_equal(5, count);
+	zassert_equal(SLOT_DEW_POINT, values[3].slot);
+	zassert_equal(SLOT_SEA_LEVEL, values[4].slot);
+	zassert_equal(1000000, values[4].data.q31_data.header.base_timestamp_ns);
+	zassert_equal(1, values[4].data.q31_data.header.reading_count);
+}
@@ -0,0 +1,257 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ *
+ */
+
+#include "wst_sensor_filter.h"
+#include "wst_sensor_types.h"
+
+#include <zephyr/ztest.h>
+#include <zephyr/sys/util.h>
+
+#include <string.h>
+
+
+static wst_sensor_filter_t filter;
+
+static void filter_suite_before(void *f)
+{
+	ARG_UNUSED(f);
+
+	memset(&filter, 0, sizeof(filter));
+	wst_sensor_filter_start(&filter);
+}
+
+ZTEST_SUITE(
+	/* SUITE_NAME */	wst_sensor_filter,
+	/* PREDICATE */		NULL,
+	/* setup_fn */		NULL,
+	/* before_fn */		filter_suite_before,
+	/* after_fn */		NULL,
+	/* teardown_fn */	NULL
+);
+
+
+static void push_burst(const q31_t* samples, size_t count)
+{
+	wst_sensor_filter_start(&filter);
+
+	for (size_t i = 0; i < count; i++) {
+		wst_sensor_filter_push(&filter, samples[i], 8);
+	}
+}
+
+static q31_t get_filtered(uint8_t stages)
+{
+	q31_t q;
+	int8_t shift;
+
+	zassert_true(wst_sensor_filter_get(&filter, stages, &q, &shift));
+	zassert_equal(8, shift);
+	return q;
+}
+
+/**
+ * @brief Test empty burst
+ *
+ * This test verifies that a burst without samples gives no value.
+ *
+ */
+ZTEST(wst_sensor_filter, test_empty)
+{
+	q31_t q;
+	int8_t shift;
+
+	zassert_false(wst_sensor_filter_get(&filter, 0, &q, &shift));
+}
+
+/**
+ * @brief Test mean and median
+ *
+ * This test verifies mean and median of bursts of odd and even
+ * number of samples.
+ *
+ */
+ZTEST(wst_sensor_filter, test_mean_median)
+{
+	static const q31_t odd[] = {500, 100, 900, 300, 700};
+	static const q31_t even[] = {400, 100, 300, 200};
+	static const q31_t skewed[] = {100, 100, 100, 1000};
+
+	push_burst(odd, ARRAY_SIZE(odd));
+	zassert_equal(500, get_filtered(0));
+	zassert_equal(500, get_filtered(WST_FILTER_MEDIAN));
+
+	// Even bursts take the mean of the two middle samples
+	push_burst(even, ARRAY_SIZE(even));
+	zassert_equal(250, get_filtered(0));
+	zassert_equal(250, get_filtered(WST_FILTER_MEDIAN));
+
+	push_burst(skewed, ARRAY_SIZE(skewed));
+	zassert_equal(325, get_filtered(0));
+	zassert_equal(100, get_filtered(WST_FILTER_MEDIAN));
+}
+
+/**
+ * @brief Test Hampel outlier rejection
+ *
+ * This test verifies that samples farther than K scaled MADs from the
+ * median are replaced with it, for bursts of odd and even number of
+ * samples.
+ *
+ */
+ZTEST(wst_sensor_filter, test_hampel)
+{
+	static const q31_t odd[] = {100, 101, 99, 100, 1000};
+	static const q31_t even[] = {10, 11, 12, 13, 100, 11};
+	static const q31_t spread[] = {100, 110, 90, 105, 95};
+
+	// MAD 1, threshold 4, the spike is replaced with the median 100
+	push_burst(odd, ARRAY_SIZE(odd));
+	zassert_equal(100, get_filtered(WST_FILTER_HAMPEL));
+
+	// Median 11, MAD 1, the spike is replaced with the median
+	push_burst(even, ARRAY_SIZE(even));
+	zassert_equal(11, get_filtered(WST_FILTER_HAMPEL));
+	zassert_equal(11, get_filtered(WST_FILTER_HAMPEL | WST_FILTER_MEDIAN));
+
+	// Samples within the threshold are kept
+	push_burst(spread, ARRAY_SIZE(spread));
+	zassert_equal(100, get_filtered(WST_FILTER_HAMPEL));
+}
+
+/**
+ * @brief Test Hampel rejection with zero MAD
+ *
+ * This test verifies that with most samples equal, any other sample
+ * is an outlier, and that equal samples are kept.
+ *
+ */
+ZTEST(wst_sensor_filter, test_hampel_mad_zero)
+{
+	static const q31_t spike[] = {500, 500, 500, 500, 900};
+	static const q31_t even[] = {500, 500, 500, 900};
+	static const q31_t flat[] = {700, 700, 700};
+
+	push_burst(spike, ARRAY_SIZE(spike));
+	zassert_equal(500, get_filtered(WST_FILTER_HAMPEL));
+
+	push_burst(even, ARRAY_SIZE(even));
+	zassert_equal(500, get_filtered(WST_FILTER_HAMPEL));
+
+	push_burst(flat, ARRAY_SIZE(flat));
+	zassert_equal(700, get_filtered(WST_FILTER_HAMPEL));
+}
+
+/**
+ * @brief Test Hampel rejection of short bursts
+ *
+ * This test verifies that bursts of two samples have no median
+ * to reject against, and are averaged.
+ *
+ */
+ZTEST(wst_sensor_filter, test_hampel_short)
+{
+	static const q31_t pair[] = {100, 900};
+
+	push_burst(pair, ARRAY_SIZE(pair));
+	zassert_equal(500, get_filtered(WST_FILTER_HAMPEL));
+}
+
+/**
+ * @brief Test exponential moving average
+ *
+ * This test verifies the moving average across bursts, starting from
+ * the first burst, and in both directions.
+ *
+ */
+ZTEST(wst_sensor_filter, test_ema)
+{
+	static const q31_t high[] = {1000};
+	static const q31_t low[] = {0};
+
+	push_burst(high, ARRAY_SIZE(high));
+	zassert_equal(1000, get_filtered(WST_FILTER_EMA));
+
+	// 1 / 4 of each step
+	push_burst(low, ARRAY_SIZE(low));
+	zassert_equal(750, get_filtered(WST_FILTER_EMA));
+
+	push_burst(low, ARRAY_SIZE(low));
+	zassert_equal(563, get_filtered(WST_FILTER_EMA));
+
+	push_burst(high, ARRAY_SIZE(high));
+	zassert_equal(672, get_filtered(WST_FILTER_EMA));
+}
+
+/**
+ * @brief Test moving average on scale change
+ *
+ * This test verifies that the moving average restarts when the burst
+ * scale changes, instead of mixing values of different shifts.
+ *
+ */
+ZTEST(wst_sensor_filter, test_ema_rescale)
+{
+	q31_t q;
+	int8_t shift;
+
+	wst_sensor_filter_push(&filter, 1000, 8);
+	zassert_true(wst_sensor_filter_get(&filter, WST_FILTER_EMA, &q, &shift));
+
+	wst_sensor_filter_start(&filter);
+	wst_sensor_filter_push(&filter, 3000, 4);
+	zassert_true(wst_sensor_filter_get(&filter, WST_FILTER_EMA, &q, &shift));
+	zassert_equal(3000, q);
+	zassert_equal(4, shift);
+}
+
+/**
+ * @brief Test samples of different scales
+ *
+ * This test verifies that burst samples are rescaled to the shift
+ * of the first sample.
+ *
+ */
+ZTEST(wst_sensor_filter, test_rescale)
+{
+	q31_t q;
+	int8_t shift;
+
+	wst_sensor_filter_push(&filter, 100, 4);
+	wst_sensor_filter_push(&filter, 100, 5);
+	wst_sensor_filter_push(&filter, 400, 3);
+
+	zassert_true(wst_sensor_filter_get(&filter, 0, &q, &shift));
+	zassert_equal(4, shift);
+	zassert_equal((100 + 200 + 200) / 3, q);
+}
+
+/**
+ * @brief Test burst overflow
+ *
+ * This test verifies that samples beyond CONFIG_WST_SENSOR_BURST_MAX
+ * overwrite the oldest ones.
+ *
+ */
+ZTEST(wst_sensor_filter, test_overflow)
+{
+	for (int i = 1; i <= CONFIG_WST_SENSOR_BURST_MAX + 3; i++) {
+		wst_sensor_filter_push(&filter, i * 100, 8);
+	}
+
+	// Samples 4 to 12 are kept
+	zassert_equal(800, get_filtered(0));
+	zassert_equal(800, get_filtered(WST_FILTER_MEDIAN));
+}
@@ -0,0 +1,165 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ *
+ */
+
+#include "wst_sensor_report.h"
+
+#include <zephyr/ztest.h>
+
+#include <errno.h>
+
+
+#define SLOT_TEMP		(0)
+#define SLOT_HUMIDITY	(1)
+#define SLOT_PRESS		(2)
+
+#define HEARTBEAT_MS	(CONFIG_WST_REPORT_HEARTBEAT_MS)
+
+
+static wst_sensor_report_t report;
+
+static void report_suite_before(void *f)
+{
+	ARG_UNUSED(f);
+
+	wst_sensor_report_init(&report);
+	zassert_ok(wst_sensor_report_set_deadband(&report, SLOT_TEMP, 200));
+	zassert_ok(wst_sensor_report_set_deadband(&report, SLOT_HUMIDITY, 1000));
+}
+
+ZTEST_SUITE(
+	/* SUITE_NAME */	wst_sensor_report,
+	/* PREDICATE */		NULL,
+	/* setup_fn */		NULL,
+	/* before_fn */		report_suite_before,
+	/* after_fn */		NULL,
+	/* teardown_fn */	NULL
+);
+
+
+static void deliver(uint16_t slot, int64_t value, int64_t now_ms)
+{
+	wst_sensor_report_sent(&report, slot, value);
+	wst_sensor_report_completed(&report, true, now_ms);
+}
+
+/**
+ * @brief Test deadband settings
+ *
+ * This test verifies that unknown slots and negative thresholds
+ * are rejected.
+ *
+ */
+ZTEST(wst_sensor_report, test_set_deadband)
+{
+	zassert_ok(wst_sensor_report_set_deadband(&report, SLOT_PRESS, 0));
+	zassert_equal(-EINVAL, wst_sensor_report_set_deadband(&report, SLOT_PRESS, -1));
+	zassert_equal(-EINVAL, wst_sensor_report_set_deadband(&report, WST_SENSOR_CHANNEL_COUNT, 100));
+}
+
+/**
+ * @brief Test channels never delivered
+ *
+ * This test verifies that every channel is due until it is delivered,
+ * and that channels without deadband are due on every uplink.
+ *
+ */
+ZTEST(wst_sensor_report, test_first_value)
+{
+	zassert_true(wst_sensor_report_is_due(&report, SLOT_TEMP, 21000, 0));
+	zassert_true(wst_sensor_report_is_due(&report, SLOT_PRESS, 101325, 0));
+
+	deliver(SLOT_PRESS, 101325, 0);
+	zassert_true(wst_sensor_report_is_due(&report, SLOT_PRESS, 101325, 1000));
+
+	// Unknown slots are never suppressed
+	zassert_true(wst_sensor_report_is_due(&report, WST_SENSOR_CHANNEL_COUNT, 0, 0));
+}
+
+/**
+ * @brief Test deadband
+ *
+ * This test verifies that a channel is due only once it moves by at
+ * least its threshold from the last delivered value, in both directions.
+ *
+ */
+ZTEST(wst_sensor_report, test_deadband)
+{
+	deliver(SLOT_TEMP, 21000, 0);
+
+	zassert_false(wst_sensor_report_is_due(&report, SLOT_TEMP, 21000, 1000));
+	zassert_false(wst_sensor_report_is_due(&report, SLOT_TEMP, 21199, 1000));
+	zassert_false(wst_sensor_report_is_due(&report, SLOT_TEMP, 20801, 1000));
+	zassert_true(wst_sensor_report_is_due(&report, SLOT_TEMP, 21200, 1000));
+	zassert_true(wst_sensor_report_is_due(&report, SLOT_TEMP, 20800, 1000));
+
+	// Slow drift is measured from the delivered value, not the last one seen
+	deliver(SLOT_TEMP, 21150, 2000);
+	zassert_false(wst_sensor_report_is_due(&report, SLOT_TEMP, 21300, 3000));
+	zassert_true(wst_sensor_report_is_due(&report, SLOT_TEMP, 21350, 3000));
+}
+
+/**
+ * @brief Test heartbeat
+ *
+ * This test verifies that an unchanged channel is due again once it was
+ * silent for CONFIG_WST_REPORT_HEARTBEAT_MS.
+ *
+ */
+ZTEST(wst_sensor_report, test_heartbeat)
+{
+	deliver(SLOT_HUMIDITY, 45000, 1000);
+
+	zassert_false(wst_sensor_report_is_due(&report, SLOT_HUMIDITY, 45000, 1000 + HEARTBEAT_MS - 1));
+	zassert_true(wst_sensor_report_is_due(&report, SLOT_HUMIDITY, 45000, 1000 + HEARTBEAT_MS));
+
+	// Delivery restarts the heartbeat
+	deliver(SLOT_HUMIDITY, 45000, 1000 + HEARTBEAT_MS);
+	zassert_false(wst_sensor_report_is_due(&report, SLOT_HUMIDITY, 45000, 1000 + HEARTBEAT_MS + 1));
+}
+
+/**
+ * @brief Test commit on send
+ *
+ * This test verifies that sent values become the delivered ones only
+ * once the uplink is delivered, and are due again after a failed uplink.
+ *
+ */
+ZTEST(wst_sensor_report, test_commit_on_send)
+{
+	deliver(SLOT_TEMP, 21000, 0);
+
+	// Uplink in flight doesn't change the delivered value
+	wst_sensor_report_sent(&report, SLOT_TEMP, 22000);
+	zassert_true(wst_sensor_report_is_due(&report, SLOT_TEMP, 22000, 1000));
+
+	// Failed uplink keeps the value due
+	wst_sensor_report_completed(&report, false, 1000);
+	zassert_true(wst_sensor_report_is_due(&report, SLOT_TEMP, 22000, 2000));
+	zassert_false(wst_sensor_report_is_due(&report, SLOT_TEMP, 21100, 2000));
+
+	// Delivered uplink commits it
+	wst_sensor_report_sent(&report, SLOT_TEMP, 22000);
+	wst_sensor_report_completed(&report, true, 3000);
+	zassert_false(wst_sensor_report_is_due(&report, SLOT_TEMP, 22000, 4000));
+	zassert_true(wst_sensor_report_is_due(&report, SLOT_TEMP, 21000, 4000));
+
+	// Channels not sent in the uplink keep their delivered values
+	deliver(SLOT_HUMIDITY, 45000, 5000);
+	wst_sensor_report_sent(&report, SLOT_TEMP, 23000);
+	wst_sensor_report_completed(&report, true, 6000);
+	zassert_false(wst_sensor_report_is_due(&report, SLOT_HUMIDITY, 45500, 7000));
+	zassert_true(wst_sensor_report_is_due(&report, SLOT_HUMIDITY, 46000, 7000));
+}
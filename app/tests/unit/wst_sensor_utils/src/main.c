@@ -0,0 +1,149 @@
+/*
+ * This file is part of Weather Station project <https://github.com/VeniaminGH/Weather-Station>.
+ * Copyright (c) 2024 Veniamin Milevski
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/gpl-3.0.html>.
+ *
+ */
+
+#include "wst_sensor_utils.h"
+
+#include <zephyr/ztest.h>
+#include <zephyr/sys/util.h>
+
+
+// Readings at the ends of the q31 range and around zero
+static const q31_t readings[] = {
+	INT32_MIN, INT32_MIN + 1, -(q31_t) BIT(30), -1000, -1, 0, 1, 1000, BIT(30), INT32_MAX - 1, INT32_MAX,
+};
+
+ZTEST_SUITE(
+	/* SUITE_NAME */	wst_sensor_utils,
+	/* PREDICATE */		NULL,
+	/* setup_fn */		NULL,
+	/* before_fn */		NULL,
+	/* after_fn */		NULL,
+	/* teardown_fn */	NULL
+);
+
+
+/**
+ * @brief Test scaled batch conversion against single values
+ *
+ * This test verifies that batch conversion is bit-exact with the single
+ * value conversion for every shift the latter takes.
+ *
+ */
+ZTEST(wst_sensor_utils, test_scaled_batch_single)
+{
+	int64_t values[ARRAY_SIZE(readings)];
+
+	for (int8_t shift = 0; shift <= 31; shift++) {
+		wst_q31_to_scaled_batch(readings, shift, 1000, values, ARRAY_SIZE(readings));
+
+		for (int i = 0; i < ARRAY_SIZE(readings); i++) {
+			zassert_equal(wst_q31_to_milli(readings[i], shift), values[i],
+				"shift %d, reading %d", shift, i);
+		}
+	}
+}
+
+/**
+ * @brief Test scaled batch conversion of negative shifts
+ *
+ * This test verifies batch conversion of readings smaller than one,
+ * which the single value conversion doesn't take, truncated toward zero.
+ *
+ */
+ZTEST(wst_sensor_utils, test_scaled_batch_negative_shift)
+{
+	static const q31_t q[] = {INT32_MIN, INT32_MAX, BIT(30), -(q31_t) BIT(30)};
+	int64_t values[ARRAY_SIZE(q)];
+
+	// -1/32, 1/32 - 2^-36, 1/64, -1/64
+	wst_q31_to_scaled_batch(q, -5, 1000, values, ARRAY_SIZE(q));
+	zassert_equal(-31, values[0]);
+	zassert_equal(31, values[1]);
+	zassert_equal(15, values[2]);
+	zassert_equal(-15, values[3]);
+
+	wst_q31_to_scaled_batch(q, -5, 1000000, values, ARRAY_SIZE(q));
+	zassert_equal(-31250, values[0]);
+	zassert_equal(31249, values[1]);
+	zassert_equal(15625, values[2]);
+	zassert_equal(-15625, values[3]);
+
+	// -2^-31, 2^-31 - 2^-62, 2^-32, -2^-32 of 2^32
+	wst_q31_to_scaled_batch(q, -31, BIT64(32), values, ARRAY_SIZE(q));
+	zassert_equal(-2, values[0]);
+	zassert_equal(1, values[1]);
+	zassert_equal(1, values[2]);
+	zassert_equal(-1, values[3]);
+}
+
+/**
+ * @brief Test scaled batch conversion of large shifts and scales
+ *
+ * This test verifies batch conversion of the largest values, up to
+ * the full int64 range for shift 31 and scale 2^32.
+ *
+ */
+ZTEST(wst_sensor_utils, test_scaled_batch_large_shift)
+{
+	static const q31_t q[] = {INT32_MIN, INT32_MAX, -1, 1};
+	int64_t values[ARRAY_SIZE(q)];
+
+	wst_q31_to_scaled_batch(q, 31, 1000, values, ARRAY_SIZE(q));
+	zassert_equal(-2147483648000LL, values[0]);
+	zassert_equal(2147483647000LL, values[1]);
+	zassert_equal(-1000, values[2]);
+	zassert_equal(1000, values[3]);
+
+	wst_q31_to_scaled_batch(q, 31, BIT64(32), values, ARRAY_SIZE(q));
+	zassert_equal(INT64_MIN, values[0]);
+	zassert_equal(INT64_MAX - (int64_t) BIT64(32) + 1, values[1]);
+	zassert_equal(-(int64_t) BIT64(32), values[2]);
+	zassert_equal(BIT64(32), values[3]);
+
+	wst_q31_to_scaled_batch(q, 30, 1, values, ARRAY_SIZE(q));
+	zassert_equal(-(q31_t) BIT(30), values[0]);
+	zassert_equal((q31_t) BIT(30) - 1, values[1]);
+	zassert_equal(0, values[2]);
+	zassert_equal(0, values[3]);
+}
+
+/**
+ * @brief Test float batch conversion
+ *
+ * This test verifies that batch conversion to floats is exact to float
+ * rounding for shifts over the whole range, with CMSIS-DSP or without.
+ *
+ */
+ZTEST(wst_sensor_utils, test_float_batch)
+{
+	float values[ARRAY_SIZE(readings)];
+
+	for (int8_t shift = -31; shift <= 31; shift++) {
+		wst_q31_to_float_batch(readings, shift, values, ARRAY_SIZE(readings));
+
+		for (int i = 0; i < ARRAY_SIZE(readings); i++) {
+			// q31 readings and powers of two are exact in double
+			float expected = (float) ((double) readings[i] / (double) BIT64(31 - shift));
+
+			zassert_equal(expected, values[i], "shift %d, reading %d", shift, i);
+		}
+	}
+
+	// 2^31 rounds the largest reading up
+	wst_q31_to_float_batch(readings, 31, values, ARRAY_SIZE(readings));
+	zassert_equal(-2147483648.0f, values[0]);
+	zassert_equal(2147483648.0f, values[ARRAY_SIZE(readings) - 1]);
+}